@@ -0,0 +1,52 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+
+#define NBLOCK 2048  // 1MB: 직접 + 간접 블록(139개)을 넘어 이중 간접 블록까지 사용
+
+char buf[512];
+
+void _error(const char *msg) {
+    printf(1, "%s\nbigfile_test failed...\n", msg);
+    exit();
+}
+
+int main() {
+    int fd, i, j;
+
+    printf(1, "### Big file test start\n");
+
+    if ((fd = open("bigfile", O_CREATE | O_RDWR)) < 0)
+        _error("Open error");
+
+    for (i = 0; i < NBLOCK; i++) {
+        for (j = 0; j < sizeof(buf); j++)
+            buf[j] = (char)(i + j);
+        if (write(fd, buf, sizeof(buf)) != sizeof(buf))
+            _error("Write error");
+    }
+    close(fd);
+    printf(1, "ok\n");
+
+    if ((fd = open("bigfile", O_RDONLY)) < 0)
+        _error("Open error");
+
+    for (i = 0; i < NBLOCK; i++) {
+        if (read(fd, buf, sizeof(buf)) != sizeof(buf))
+            _error("Read error");
+        for (j = 0; j < sizeof(buf); j++)
+            if (buf[j] != (char)(i + j))
+                _error("Data mismatch");
+    }
+    close(fd);
+    printf(1, "ok\n");
+
+    if (unlink("bigfile") < 0)
+        _error("Unlink error");
+    printf(1, "ok\n");
+
+    printf(1, "### Big file test passed...\n");
+
+    exit();
+}
@@ -0,0 +1,365 @@
+// Buffer cache.
+//
+// The buffer cache is a hash table of linked lists of buf structures
+// holding cached copies of disk block contents.  Caching disk blocks
+// in memory reduces the number of disk reads and also provides
+// a synchronization point for disk blocks used by multiple processes.
+//
+// Interface:
+// * To get a buffer for a particular disk block, call bread.
+// * After changing buffer data, call bwrite to write it to disk.
+// * When done with the buffer, call brelse.
+// * Do not use the buffer after calling brelse.
+// * Only one process at a time can use a buffer,
+//     so do not keep them longer than necessary.
+//
+// The implementation uses two state flags internally:
+// * B_VALID: the buffer data has been read from the disk.
+// * B_DIRTY: the buffer data has been modified
+//     and needs to be written to disk.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+
+// 추가: 버퍼 캐시를 (dev, blockno) 해시 버킷으로 나눔.
+// 각 버킷은 자신의 lock과 LRU 리스트를 가지므로 서로 다른 블록을 찾는
+// CPU들이 하나의 lock에서 경쟁하지 않음.
+// 버킷에 빈 버퍼가 없어 다른 버킷의 버퍼를 가져올 때만 bcache.lock을 잡음.
+// 두 버킷 lock을 동시에 잡는 곳은 bcache.lock 아래뿐이므로 교착이 없음.
+#define NBUCKET 13
+
+struct bucket {
+  struct spinlock lock;
+
+  // Linked list of buffers in this bucket, through prev/next.
+  // head.next is most recently used.
+  struct buf head;
+};
+
+struct {
+  struct spinlock lock;   // serializes moving buffers between buckets
+  struct buf buf[NBUF];
+  struct bucket bucket[NBUCKET];
+  int nwait;              // bget()s sleeping for a free buffer
+} bcache;
+
+static struct bucket*
+bhash(uint dev, uint blockno)
+{
+  return &bcache.bucket[(dev * 31 + blockno) % NBUCKET];
+}
+
+// Insert b at the MRU end of bucket bk.  Caller must hold bk->lock.
+static void
+binsert(struct bucket *bk, struct buf *b)
+{
+  b->next = bk->head.next;
+  b->prev = &bk->head;
+  bk->head.next->prev = b;
+  bk->head.next = b;
+}
+
+// Unlink b from its bucket.  Caller must hold the bucket's lock.
+static void
+bunlink(struct buf *b)
+{
+  b->next->prev = b->prev;
+  b->prev->next = b->next;
+}
+
+void
+binit(void)
+{
+  struct buf *b;
+  struct bucket *bk;
+
+  initlock(&bcache.lock, "bcache");
+
+//PAGEBREAK!
+  // Create one empty list per bucket.
+  for(bk = bcache.bucket; bk < bcache.bucket+NBUCKET; bk++){
+    initlock(&bk->lock, "bcache.bucket");
+    bk->head.prev = &bk->head;
+    bk->head.next = &bk->head;
+  }
+  // All buffers start out holding (dev 0, block 0).
+  bk = bhash(0, 0);
+  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
+    initsleeplock(&b->lock, "buffer");
+    binsert(bk, b);
+  }
+}
+
+// Look for block on device dev in bucket bk.
+// If found, take a reference to it.  Caller must hold bk->lock.
+static struct buf*
+blookup(struct bucket *bk, uint dev, uint blockno)
+{
+  struct buf *b;
+
+  for(b = bk->head.next; b != &bk->head; b = b->next){
+    if(b->dev == dev && b->blockno == blockno){
+      b->refcnt++;
+      return b;
+    }
+  }
+  return 0;
+}
+
+// Find the least recently used unused buffer, first in bk and then
+// in the other buckets, and move it into bk for (dev, blockno).
+// Caller must hold bcache.lock and bk->lock.
+// Returns 0 if every buffer is in use.
+static struct buf*
+brecycle(struct bucket *bk, uint dev, uint blockno)
+{
+  struct buf *b;
+  struct bucket *victim;
+  int i;
+
+  // Even if refcnt==0, B_DIRTY indicates a buffer is in use
+  // because log.c has modified it but not yet committed it.
+  for(i = 0; i < NBUCKET; i++){
+    victim = &bcache.bucket[(bk - bcache.bucket + i) % NBUCKET];
+    if(victim != bk)
+      acquire(&victim->lock);
+    for(b = victim->head.prev; b != &victim->head; b = b->prev){
+      if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0){
+        bunlink(b);
+        if(victim != bk){
+          release(&victim->lock);
+        }
+        binsert(bk, b);
+        b->dev = dev;
+        b->blockno = blockno;
+        b->flags = 0;
+        b->refcnt = 1;
+        return b;
+      }
+    }
+    if(victim != bk)
+      release(&victim->lock);
+  }
+  return 0;
+}
+
+// 추가: 지금 바로 재활용할 수 있는 버퍼 수.
+// Caller must hold bcache.lock.
+static int
+bnfree(void)
+{
+  struct buf *b;
+  struct bucket *bk;
+  int n;
+
+  n = 0;
+  for(bk = bcache.bucket; bk < bcache.bucket+NBUCKET; bk++){
+    acquire(&bk->lock);
+    for(b = bk->head.next; b != &bk->head; b = b->next)
+      if(b->refcnt == 0 && (b->flags & B_DIRTY) == 0)
+        n++;
+    release(&bk->lock);
+  }
+  return n;
+}
+
+// Look through buffer cache for block on device dev.
+// If not found, allocate a buffer.
+// In either case, return locked buffer.
+// 추가: 빈 버퍼가 없으면 panic 대신 하나가 풀릴 때까지 잠듦.
+static struct buf*
+bget(uint dev, uint blockno)
+{
+  struct buf *b;
+  struct bucket *bk;
+
+  bk = bhash(dev, blockno);
+
+  // Is the block already cached?
+  acquire(&bk->lock);
+  if((b = blookup(bk, dev, blockno)) != 0){
+    release(&bk->lock);
+    acquiresleep(&b->lock);
+    return b;
+  }
+  release(&bk->lock);
+
+  // Not cached; recycle an unused buffer.
+  // Look again after taking bcache.lock, since another process
+  // may have brought the block in while bk->lock was released.
+  // nwait는 brecycle()이 버킷을 훑기 전에 올림. bunref()는 버킷 lock을
+  // 잡은 채 nwait를 읽으므로, 훑은 뒤에 풀린 버퍼라면 bunref()가 nwait를
+  // 보고 bcache.lock을 기다렸다가 잠든 이 프로세스를 깨움.
+  acquire(&bcache.lock);
+  bcache.nwait++;
+  for(;;){
+    acquire(&bk->lock);
+    if((b = blookup(bk, dev, blockno)) != 0 ||
+       (b = brecycle(bk, dev, blockno)) != 0)
+      break;
+    release(&bk->lock);
+    sleep(&bcache, &bcache.lock);
+  }
+  bcache.nwait--;
+  release(&bk->lock);
+  release(&bcache.lock);
+  acquiresleep(&b->lock);
+  return b;
+}
+
+// 추가: virtio 디스크가 있으면 루트 디바이스는 virtio로, 나머지는 IDE로 보냄.
+static void
+bdiskrw(struct buf **bs, int n)
+{
+  if(havevirtio && bs[0]->dev == ROOTDEV)
+    virtiorwv(bs, n);
+  else
+    iderwv(bs, n);
+}
+
+// Return a locked buf with the contents of the indicated block.
+struct buf*
+bread(uint dev, uint blockno)
+{
+  struct buf *b;
+
+  b = bget(dev, blockno);
+  if((b->flags & B_VALID) == 0) {
+    bdiskrw(&b, 1);
+  }
+  return b;
+}
+
+// 추가: readahead용 비동기 읽기.
+// 블록이 캐시에 없으면 빈 버퍼를 잡아 디스크 읽기를 요청만 하고 바로 반환함.
+// 읽기가 끝나면 ideintr가 bdone()으로 버퍼를 놓아줌.
+// 이미 캐시에 있으면 아무것도 하지 않음.
+// 빈 버퍼가 MAXOPBLOCKS개보다 적으면 -1을 돌려주어 readahead를 멈추게 함.
+// 남은 버퍼는 bmap의 간접 블록과 다른 프로세스의 bread 몫임.
+int
+breadahead(uint dev, uint blockno)
+{
+  struct buf *b;
+  struct bucket *bk;
+
+  bk = bhash(dev, blockno);
+  acquire(&bk->lock);
+  for(b = bk->head.next; b != &bk->head; b = b->next){
+    if(b->dev == dev && b->blockno == blockno){
+      release(&bk->lock);
+      return 0;
+    }
+  }
+  release(&bk->lock);
+
+  acquire(&bcache.lock);
+  if(bnfree() < MAXOPBLOCKS){
+    release(&bcache.lock);
+    return -1;
+  }
+  acquire(&bk->lock);
+  for(b = bk->head.next; b != &bk->head; b = b->next){
+    if(b->dev == dev && b->blockno == blockno)
+      break;
+  }
+  if(b != &bk->head || (b = brecycle(bk, dev, blockno)) == 0){
+    release(&bk->lock);
+    release(&bcache.lock);
+    return 0;
+  }
+  b->flags = B_ASYNC;
+  release(&bk->lock);
+  release(&bcache.lock);
+  // refcnt가 0이었으므로 sleep-lock을 가진 프로세스가 없어 바로 얻어짐
+  acquiresleep(&b->lock);
+  if(havevirtio && dev == ROOTDEV)
+    virtiorw_async(b);
+  else
+    iderw_async(b);
+  return 0;
+}
+
+// Write b's contents to disk.  Must be locked.
+void
+bwrite(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("bwrite");
+  b->flags |= B_DIRTY;
+  bdiskrw(&b, 1);
+}
+
+// 추가: 같은 디바이스의 잠긴 버퍼 n개를 한 번에 디스크에 씀.
+// 드라이버가 요청들을 동시에 진행하거나 연속 블록을 합칠 수 있음.
+void
+bwritev(struct buf **bs, int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++){
+    if(!holdingsleep(&bs[i]->lock) || bs[i]->dev != bs[0]->dev)
+      panic("bwritev");
+    bs[i]->flags |= B_DIRTY;
+  }
+  if(n > 0)
+    bdiskrw(bs, n);
+}
+
+// Drop a reference to b.
+// Move to the head of the MRU list if no one is using it.
+// 추가: 빈 버퍼를 기다리는 bget()이 있으면 깨움.
+static void
+bunref(struct buf *b)
+{
+  struct bucket *bk;
+  int wake;
+
+  bk = bhash(b->dev, b->blockno);
+  acquire(&bk->lock);
+  b->refcnt--;
+  wake = 0;
+  if (b->refcnt == 0) {
+    // no one is waiting for it.
+    bunlink(b);
+    binsert(bk, b);
+    wake = bcache.nwait > 0;  // bk->lock을 잡은 채 읽어야 함 (bget 참고)
+  }
+  
+  release(&bk->lock);
+
+  if(wake){
+    acquire(&bcache.lock);
+    wakeup(&bcache);
+    release(&bcache.lock);
+  }
+}
+
+// Release a locked buffer.
+// Move to the head of the MRU list.
+void
+brelse(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("brelse");
+
+  releasesleep(&b->lock);
+  bunref(b);
+}
+
+// 추가: breadahead()로 요청한 읽기가 끝났을 때 ideintr에서 호출됨.
+// 요청한 프로세스는 기다리지 않으므로 대신 sleep-lock과 참조를 놓아줌.
+void
+bdone(struct buf *b)
+{
+  b->flags &= ~B_ASYNC;
+  releasesleep(&b->lock);
+  bunref(b);
+}
+//PAGEBREAK!
+// Blank page.
+
@@ -18,6 +18,9 @@ void            binit(void);
 struct buf*     bread(uint, uint);
 void            brelse(struct buf*);
 void            bwrite(struct buf*);
+void            bwritev(struct buf**, int);
+int             breadahead(uint, uint);
+void            bdone(struct buf*);
 
 // console.c
 void            consoleinit(void);
@@ -36,11 +39,18 @@ void            fileinit(void);
 int             fileread(struct file*, char*, int n);
 int             filestat(struct file*, struct stat*);
 int             filewrite(struct file*, char*, int n);
+int             filecopy(struct file*, struct file*, int);
+int             fileallocate(struct file*, uint, uint);
+int             filetruncate(struct file*, uint);
+int             filepread(struct file*, char*, int, uint);
+int             filepwrite(struct file*, char*, int, uint);
+int             fileprefetch(struct file*, int, int);
 
 // fs.c
 void            readsb(int dev, struct superblock *sb);
 int             dirlink(struct inode*, char*, uint);
 struct inode*   dirlookup(struct inode*, char*, uint*);
+void            dirunlink(struct inode*, char*, uint);
 struct inode*   ialloc(uint, short);
 struct inode*   idup(struct inode*);
 void            iinit(int dev);
@@ -53,13 +63,19 @@ int             namecmp(const char*, const char*);
 struct inode*   namei(char*);
 struct inode*   nameiparent(char*, char*);
 int             readi(struct inode*, char*, uint, uint);
+int             readahead(struct inode*, uint, uint);
 void            stati(struct inode*, struct stat*);
 int             writei(struct inode*, char*, uint, uint);
+int             copyi(struct inode*, uint, struct inode*, uint, uint);
+void            ishrink(struct inode*, uint);
+int             igrow(struct inode*, uint, uint);
 
 // ide.c
 void            ideinit(void);
 void            ideintr(void);
 void            iderw(struct buf*);
+void            iderwv(struct buf**, int);
+void            iderw_async(struct buf*);
 
 // ioapic.c
 void            ioapicenable(int irq, int cpu);
@@ -71,6 +87,9 @@ char*           kalloc(void);
 void            kfree(char*);
 void            kinit1(void*, void*);
 void            kinit2(void*, void*);
+void            kref(char*);
+int             krefcount(char*);
+char*           kallocsuper(void);
 
 // kbd.c
 void            kbdintr(void);
@@ -89,6 +108,9 @@ void            initlog(int dev);
 void            log_write(struct buf*);
 void            begin_op();
 void            end_op();
+void            begin_opn(int);
+void            end_opn(int);
+void            log_flush(void);
 
 // mp.c
 extern int      ismp;
@@ -98,11 +120,18 @@ void            mpinit(void);
 void            picenable(int);
 void            picinit(void);
 
+// pci.c
+uint            pciread(uint, uint);
+void            pciwrite(uint, uint, uint);
+int             pcifind(ushort, ushort);
+
 // pipe.c
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
 int             piperead(struct pipe*, char*, int);
 int             pipewrite(struct pipe*, char*, int);
+int             pipesplicein(struct pipe*, struct file*, int);
+int             pipespliceout(struct pipe*, struct file*, int);
 
 //PAGEBREAK: 16
 // proc.c
@@ -111,6 +140,7 @@ void            exit(void);
 int             fork(void);
 int             growproc(int);
 int             kill(int);
+void            kthread(char*, void(*)(void));
 struct cpu*     mycpu(void);
 struct proc*    myproc();
 void            pinit(void);
@@ -154,29 +184,66 @@ char*           strncpy(char*, const char*, int);
 // syscall.c
 int             argint(int, int*);
 int             argptr(int, char**, int);
+int             argptrw(int, char**, int);
 int             argstr(int, char**);
 int             fetchint(uint, int*);
 int             fetchstr(uint, char**);
 void            syscall(void);
+void            syscallinit(void);
+void            syscallstat(void);
 
 // timer.c
 void            timerinit(void);
 
+// tmpfs.c
+void            tmpinit(void);
+uint            tmpialloc(short);
+void            tmpiload(struct inode*);
+void            tmpiupdate(struct inode*);
+void            tmpitrunc(struct inode*, uint);
+int             tmpreadi(struct inode*, char*, uint, uint);
+int             tmpwritei(struct inode*, char*, uint, uint);
+int             tmpigrow(struct inode*, uint);
+
 // trap.c
 void            idtinit(void);
+void            sysenterinit(void);
 extern uint     ticks;
 void            tvinit(void);
 extern struct spinlock tickslock;
+extern int      havesysenter;
+extern char     vdsopage[];
 
 // uart.c
 void            uartinit(void);
 void            uartintr(void);
 void            uartputc(int);
+void            uartflush(void);
+
+// uring.c
+void            uringinit(void);
+int             uringsubmit(int);
+void            uringwait(int);
+void            uringdrain(struct proc*);
+void            uringfree(struct proc*);
+
+// virtio.c
+void            virtioinit(void);
+void            virtiointr(void);
+void            virtiorw(struct buf*);
+void            virtiorwv(struct buf**, int);
+void            virtiorw_async(struct buf*);
+extern int      havevirtio;
+extern int      virtioirq;
 
 // vm.c
 void            seginit(void);
 void            kvmalloc(void);
 pde_t*          setupkvm(void);
+int             vdsomap(pde_t*, struct proc*);
+int             cowcopy(pde_t*, uint);
+int             superalloc(pde_t*, uint, uint);
+extern char*    zeropage;
 char*           uva2ka(pde_t*, char*);
 int             allocuvm(pde_t*, uint, uint);
 int             deallocuvm(pde_t*, uint, uint);
@@ -187,8 +254,11 @@ pde_t*          copyuvm(pde_t*, uint);
 void            switchuvm(struct proc*);
 void            switchkvm(void);
 int             copyout(pde_t*, uint, void*, uint);
+int             copyin(pde_t*, void*, uint, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
 pte_t *walkpgdir(pde_t *pgdir, const void *va, int alloc);
+uint            ptepa(pte_t*, const void*);
+int             uvmwritable(pde_t*, uint, uint);
 int mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm);
 
 // number of elements in fixed-size array
@@ -0,0 +1,371 @@
+//
+// File descriptors
+//
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "stat.h"
+#include "fs.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "file.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+struct devsw devsw[NDEV];
+struct {
+  struct spinlock lock;
+  struct file file[NFILE];
+  struct file *free;  // 추가: ref가 0인 file들의 리스트
+} ftable;
+
+void
+fileinit(void)
+{
+  struct file *f;
+
+  initlock(&ftable.lock, "ftable");
+  for(f = ftable.file + NFILE - 1; f >= ftable.file; f--){
+    f->fnext = ftable.free;
+    ftable.free = f;
+  }
+}
+
+// Allocate a file structure.
+struct file*
+filealloc(void)
+{
+  struct file *f;
+
+  acquire(&ftable.lock);
+  if((f = ftable.free) != 0){
+    ftable.free = f->fnext;
+    f->ref = 1;
+    f->ra_next = f->ra_end = f->ra_win = 0;
+  }
+  release(&ftable.lock);
+  return f;
+}
+
+// Increment ref count for file f.
+struct file*
+filedup(struct file *f)
+{
+  acquire(&ftable.lock);
+  if(f->ref < 1)
+    panic("filedup");
+  f->ref++;
+  release(&ftable.lock);
+  return f;
+}
+
+// Close file f.  (Decrement ref count, close when reaches 0.)
+void
+fileclose(struct file *f)
+{
+  struct file ff;
+
+  acquire(&ftable.lock);
+  if(f->ref < 1)
+    panic("fileclose");
+  if(--f->ref > 0){
+    release(&ftable.lock);
+    return;
+  }
+  ff = *f;
+  f->ref = 0;
+  f->type = FD_NONE;
+  f->fnext = ftable.free;
+  ftable.free = f;
+  release(&ftable.lock);
+
+  if(ff.type == FD_PIPE)
+    pipeclose(ff.pipe, ff.writable);
+  else if(ff.type == FD_INODE && ff.ip->dev == TMPDEV){
+    iput(ff.ip);  // 추가: tmpfs inode는 해제해도 로그를 쓰지 않음
+  } else if(ff.type == FD_INODE){
+    begin_op();
+    iput(ff.ip);
+    end_op();
+  }
+}
+
+// Get metadata about file f.
+int
+filestat(struct file *f, struct stat *st)
+{
+  if(f->type == FD_INODE){
+    ilock(f->ip);
+    stati(f->ip, st);
+    iunlock(f->ip);
+    return 0;
+  }
+  return -1;
+}
+
+// 추가: 순차 읽기를 감지해 readahead를 요청함.
+// 이전 read가 끝난 곳에서 다시 읽으면 윈도우를 두 배로 키우고(RAMAX까지),
+// 아니면 윈도우를 0으로 되돌림. 이번 read 범위는 readi가 곧 직접 읽으므로
+// 그 뒤 윈도우(최대 RAMAX 블록) 중 아직 요청하지 않은 부분만 미리 요청함.
+// 큰 read 하나가 버퍼 캐시를 다 차지하지 않도록 하기 위함.
+// Caller must hold f->ip->lock.
+static void
+fileraupdate(struct file *f, int n)
+{
+  uint start, end;
+
+  if(f->off == f->ra_next){
+    if(f->ra_win == 0)
+      f->ra_win = RAMIN;
+    else if(f->ra_win < RAMAX)
+      f->ra_win = min(f->ra_win * 2, RAMAX);
+  } else {
+    f->ra_win = 0;
+    f->ra_end = f->off;
+  }
+  f->ra_next = f->off + n;
+
+  start = f->ra_end > f->ra_next ? f->ra_end : f->ra_next;
+  end = f->ra_next + f->ra_win * BSIZE;
+  if(start < end){
+    readahead(f->ip, start, end - start);
+    f->ra_end = end;
+  }
+}
+
+// Read from file f.
+int
+fileread(struct file *f, char *addr, int n)
+{
+  int r;
+
+  if(f->readable == 0)
+    return -1;
+  if(f->type == FD_PIPE)
+    return piperead(f->pipe, addr, n);
+  if(f->type == FD_INODE){
+    ilock(f->ip);
+    if(n > 0)
+      fileraupdate(f, n);
+    if((r = readi(f->ip, addr, f->off, n)) > 0)
+      f->off += r;
+    iunlock(f->ip);
+    return r;
+  }
+  panic("fileread");
+}
+
+// 추가: pread. f->off를 쓰거나 바꾸지 않고 off부터 읽음.
+int
+filepread(struct file *f, char *addr, int n, uint off)
+{
+  int r;
+
+  if(f->readable == 0 || f->type != FD_INODE)
+    return -1;
+  ilock(f->ip);
+  r = readi(f->ip, addr, off, n);
+  iunlock(f->ip);
+  return r;
+}
+
+// 추가: off부터 n바이트를 읽을 것이라고 미리 알려 줌 (uring_enter).
+// 블록을 readahead로 디스크에 맡겨 두기만 하고 기다리지 않음.
+// off가 음수면 f->off부터. 빈 버퍼가 모자라 멈췄으면 -1.
+int
+fileprefetch(struct file *f, int off, int n)
+{
+  int r;
+
+  if(f->readable == 0 || f->type != FD_INODE || n <= 0)
+    return 0;
+  ilock(f->ip);
+  r = readahead(f->ip, off < 0 ? f->off : off, n);
+  iunlock(f->ip);
+  return r;
+}
+
+static int filewriteat(struct file*, char*, int, uint*);
+
+//PAGEBREAK!
+// Write to file f.
+int
+filewrite(struct file *f, char *addr, int n)
+{
+  if(f->writable == 0)
+    return -1;
+  if(f->type == FD_PIPE)
+    return pipewrite(f->pipe, addr, n);
+  if(f->type == FD_INODE)
+    return filewriteat(f, addr, n, &f->off);
+  panic("filewrite");
+}
+
+// 추가: pwrite. f->off 대신 off부터 씀.
+int
+filepwrite(struct file *f, char *addr, int n, uint off)
+{
+  if(f->writable == 0 || f->type != FD_INODE)
+    return -1;
+  return filewriteat(f, addr, n, &off);
+}
+
+// Write to inode file f at *off, advancing *off.
+static int
+filewriteat(struct file *f, char *addr, int n, uint *off)
+{
+  int r;
+
+  // 추가: tmpfs는 로그를 쓰지 않으므로 트랜잭션 없이 한 번에 씀
+  if(f->ip->dev == TMPDEV){
+    ilock(f->ip);
+    if((r = writei(f->ip, addr, *off, n)) > 0)
+      *off += r;
+    iunlock(f->ip);
+    return r == n ? n : -1;
+  }
+
+  // write a few blocks at a time to avoid exceeding
+  // the maximum log transaction size, including
+  // i-node, indirect and double indirect blocks,
+  // allocation blocks, and 2 blocks of slop for
+  // non-aligned writes.
+  // this really belongs lower down, since writei()
+  // might be writing a device like the console.
+  int max = ((MAXOPBLOCKS-1-2-2) / 2) * 512;
+  int i = 0;
+  while(i < n){
+    int n1 = n - i;
+    if(n1 > max)
+      n1 = max;
+
+    begin_op();
+    ilock(f->ip);
+    if ((r = writei(f->ip, addr + i, *off, n1)) > 0)
+      *off += r;
+    iunlock(f->ip);
+    end_op();
+
+    if(r < 0)
+      break;
+    if(r != n1)
+      panic("short filewrite");
+    i += r;
+  }
+  return i == n ? n : -1;
+}
+
+// 추가: copy_file_range. in의 오프셋에서 out의 오프셋으로 n바이트를
+// 커널 안에서 복사하고 두 오프셋을 모두 옮김.
+// 같은 파일에서 두 범위가 겹치면 -1 (Linux와 같음). in과 out이 같은
+// struct file이면 오프셋도 같으므로 여기에 걸림.
+// 한 트랜잭션에 로그를 COPYOP개 system call 분량만큼 예약하고,
+// 그 안에 들어가는 만큼(i-node, indirect와 double indirect 블록,
+// bitmap 블록, 정렬되지 않은 양 끝 블록을 빼고) 한 번에 복사함.
+#define COPYOP  (LOGSIZE/MAXOPBLOCKS/2)
+#define COPYMAX ((COPYOP*MAXOPBLOCKS-1-1-3-2-2) * BSIZE)
+
+int
+filecopy(struct file *in, struct file *out, int n)
+{
+  int r, m, tot;
+  struct inode *a, *b;
+
+  if(in->readable == 0 || out->writable == 0 || n < 0)
+    return -1;
+  if(in->type != FD_INODE || out->type != FD_INODE)
+    return -1;
+  if(in->ip == out->ip && in->off < out->off + n && out->off < in->off + n)
+    return -1;
+  // Locking order below is only safe for plain files.
+  if(in->ip->type != T_FILE || out->ip->type != T_FILE)
+    return -1;
+
+  // Lock the two inodes in inum order to avoid deadlock.
+  a = in->ip;
+  b = out->ip;
+  if(b->inum < a->inum){
+    a = out->ip;
+    b = in->ip;
+  }
+
+  for(tot = 0; tot < n; tot += r){
+    m = min(n - tot, COPYMAX);
+    begin_opn(COPYOP);
+    ilock(a);
+    if(b != a)
+      ilock(b);
+    if((r = copyi(in->ip, in->off, out->ip, out->off, m)) > 0){
+      in->off += r;
+      out->off += r;
+    }
+    if(b != a)
+      iunlock(b);
+    iunlock(a);
+    end_opn(COPYOP);
+
+    if(r < 0)
+      return tot > 0 ? tot : -1;
+    if(r < m){  // end of input
+      tot += r;
+      break;
+    }
+  }
+  return tot;
+}
+
+// 추가: fallocate. 파일이 off+len 바이트까지 블록을 갖도록 미리 할당함.
+// 한 트랜잭션에 들어가는 만큼(i-node, indirect와 double indirect 블록,
+// 모든 bitmap 블록을 빼고) 연속된 블록을 한 번에 할당함.
+#define GROWMAX (COPYOP*MAXOPBLOCKS-1-1-3-(FSSIZE/BPB+1))
+
+int
+fileallocate(struct file *f, uint off, uint len)
+{
+  uint end;
+  int r;
+
+  if(f->writable == 0 || f->type != FD_INODE)
+    return -1;
+  end = off + len;
+  if(end < off)
+    return -1;
+
+  do {
+    begin_opn(COPYOP);
+    ilock(f->ip);
+    r = igrow(f->ip, end, GROWMAX);
+    iunlock(f->ip);
+    end_opn(COPYOP);
+  } while(r >= 0 && r < end);
+  return r < 0 ? -1 : 0;
+}
+
+// 추가: ftruncate. 줄일 때는 블록을 한 트랜잭션에서 해제하고,
+// 늘릴 때는 fallocate처럼 extent로 할당함.
+int
+filetruncate(struct file *f, uint len)
+{
+  int shrink;
+
+  if(f->writable == 0 || f->type != FD_INODE)
+    return -1;
+
+  begin_op();
+  ilock(f->ip);
+  if(f->ip->type != T_FILE){
+    iunlock(f->ip);
+    end_op();
+    return -1;
+  }
+  if((shrink = len < f->ip->size))
+    ishrink(f->ip, len);
+  iunlock(f->ip);
+  end_op();
+
+  if(shrink)
+    return 0;
+  return fileallocate(f, 0, len);
+}
+
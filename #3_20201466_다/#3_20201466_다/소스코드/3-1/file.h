@@ -0,0 +1,47 @@
+struct file {
+  enum { FD_NONE, FD_PIPE, FD_INODE } type;
+  int ref; // reference count
+  char readable;
+  char writable;
+  struct pipe *pipe;
+  struct inode *ip;
+  uint off;
+
+  // 추가: 순차 읽기 readahead 상태
+  uint ra_next;  // 순차 읽기라면 다음 read가 시작될 오프셋
+  uint ra_end;   // 이미 readahead를 요청한 끝 오프셋
+  uint ra_win;   // 현재 readahead 윈도우 크기(블록 수)
+
+  struct file *fnext;  // 추가: ftable free list
+};
+
+
+// in-memory copy of an inode
+struct inode {
+  uint dev;           // Device number
+  uint inum;          // Inode number
+  int ref;            // Reference count
+  struct inode *hnext;   // 추가: icache hash chain
+  struct inode *lprev;   // 추가: LRU list of unreferenced inodes
+  struct inode *lnext;
+  struct sleeplock lock; // protects everything below here
+  int valid;          // inode has been read from disk?
+
+  short type;         // copy of disk inode
+  short major;
+  short minor;
+  short nlink;
+  uint size;
+  uint addrs[NDIRECT+2];
+};
+
+// table mapping major device number to
+// device functions
+struct devsw {
+  int (*read)(struct inode*, char*, int);
+  int (*write)(struct inode*, char*, int);
+};
+
+extern struct devsw devsw[];
+
+#define CONSOLE 1
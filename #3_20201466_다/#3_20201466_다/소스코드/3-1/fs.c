@@ -0,0 +1,1259 @@
+// File system implementation.  Five layers:
+//   + Blocks: allocator for raw disk blocks.
+//   + Log: crash recovery for multi-step updates.
+//   + Files: inode allocator, reading, writing, metadata.
+//   + Directories: inode with special contents (list of other inodes!)
+//   + Names: paths like /usr/rtm/xv6/fs.c for convenient naming.
+//
+// This file contains the low-level file system manipulation
+// routines.  The (higher-level) system call implementations
+// are in sysfile.c.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "stat.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+#include "file.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+static void itrunc(struct inode*);
+static void dpurge(uint, uint);
+// there should be one superblock per disk device, but we run with
+// only one device
+struct superblock sb; 
+
+// Read the super block.
+void
+readsb(int dev, struct superblock *sb)
+{
+  struct buf *bp;
+
+  bp = bread(dev, 1);
+  memmove(sb, bp->data, sizeof(*sb));
+  brelse(bp);
+}
+
+// Zero a block.
+static void
+bzero(int dev, int bno)
+{
+  struct buf *bp;
+
+  bp = bread(dev, bno);
+  memset(bp->data, 0, BSIZE);
+  log_write(bp);
+  brelse(bp);
+}
+
+// Blocks.
+
+// 추가: 빈 블록 요약.
+// bitmap 블록마다 남은 빈 블록 수를 메모리에 들고 있어서
+// 꽉 찬 bitmap 블록은 읽지 않고 건너뜀. 검색은 0번 블록이 아니라
+// 마지막으로 할당한 블록 다음(hint)부터 시작함(next-fit).
+// 로그 복구가 끝난 뒤의 bitmap으로 세어야 하므로 처음 쓸 때 만듦.
+#define NBMAP (FSSIZE/BPB + 1)
+
+struct {
+  struct spinlock lock;
+  int loading;
+  int loaded;
+  uint hint;          // where the next search starts
+  uint nfree[NBMAP];  // free blocks per bitmap block
+} bsum;
+
+// Count the free blocks of every bitmap block, once.
+static void
+bsumload(uint dev)
+{
+  struct buf *bp;
+  uint b, bi, n;
+
+  acquire(&bsum.lock);
+  while(bsum.loading)
+    sleep(&bsum, &bsum.lock);
+  if(bsum.loaded){
+    release(&bsum.lock);
+    return;
+  }
+  if(sb.size > NBMAP*BPB)
+    panic("bsumload: disk too big");
+  bsum.loading = 1;
+  release(&bsum.lock);
+
+  for(b = 0; b < sb.size; b += BPB){
+    bp = bread(dev, BBLOCK(b, sb));
+    n = 0;
+    for(bi = 0; bi < BPB && b + bi < sb.size; bi++)
+      if((bp->data[bi/8] & (1 << (bi % 8))) == 0)
+        n++;
+    brelse(bp);
+    bsum.nfree[b / BPB] = n;
+  }
+
+  acquire(&bsum.lock);
+  bsum.hint = 0;
+  bsum.loading = 0;
+  bsum.loaded = 1;
+  wakeup(&bsum);
+  release(&bsum.lock);
+}
+
+// Find free blocks in [from, to), which must lie within one
+// bitmap block: the first run of at least want free blocks, or
+// else the longest run there is.  Mark up to want of them in use,
+// set *got to how many, and return the first.  Returns 0 if there
+// is none (block 0 holds the boot sector and is never free).
+static uint
+bscan(uint dev, uint from, uint to, uint want, uint *got)
+{
+  struct buf *bp;
+  uint b, bi, start, len, best, bestlen;
+
+  bp = bread(dev, BBLOCK(from, sb));
+  start = len = best = bestlen = 0;
+  for(b = from; b < to && bestlen < want; b++){
+    bi = b % BPB;
+    if(len == 0 && bi % 8 == 0 && b + 8 <= to && bp->data[bi/8] == 0xff){
+      b += 7;  // all eight in use
+      continue;
+    }
+    if(bp->data[bi/8] & (1 << (bi % 8))){  // Is block in use?
+      len = 0;
+      continue;
+    }
+    if(len++ == 0)
+      start = b;
+    if(len > bestlen){
+      best = start;
+      bestlen = len;
+    }
+  }
+  if(bestlen == 0){
+    brelse(bp);
+    return 0;
+  }
+  for(b = best; b < best + bestlen; b++){
+    bi = b % BPB;
+    bp->data[bi/8] |= 1 << (bi % 8);  // Mark block in use.
+  }
+  log_write(bp);
+  brelse(bp);
+  acquire(&bsum.lock);
+  bsum.nfree[best / BPB] -= bestlen;
+  release(&bsum.lock);
+  *got = bestlen;
+  return best;
+}
+
+// 추가: 연속된 빈 블록을 최대 want개 할당하고 0으로 채움.
+// 할당한 개수를 *got에 넣고 첫 블록 번호를 반환함.
+// prev가 0이 아니면(파일의 바로 앞 블록) 그 바로 뒤를 먼저 시도하고,
+// 아니면 hint부터 빈 블록이 남은 bitmap 블록만 차례로 찾아봄.
+static uint
+ballocrun(uint dev, uint prev, uint want, uint *got)
+{
+  uint b, i, g, ng, start, from, to, n;
+
+  bsumload(dev);
+
+  if(prev != 0 && prev + 1 < sb.size){
+    from = prev + 1;
+    to = min(from + want, min((from / BPB + 1) * BPB, sb.size));
+    if((b = bscan(dev, from, to, want, got)) != 0)
+      goto found;
+  }
+
+  acquire(&bsum.lock);
+  start = bsum.hint;
+  release(&bsum.lock);
+
+  // Visit the group holding start first, from start on, and
+  // come back to its beginning last.
+  ng = (sb.size + BPB - 1) / BPB;
+  for(i = 0; i <= ng; i++){
+    g = (start / BPB + i) % ng;
+    from = g * BPB;
+    to = min(from + BPB, sb.size);
+    if(i == 0)
+      from = start;
+    else if(i == ng)
+      to = start;
+    acquire(&bsum.lock);
+    n = bsum.nfree[g];
+    release(&bsum.lock);
+    if(n > 0 && from < to && (b = bscan(dev, from, to, want, got)) != 0)
+      goto found;
+  }
+  panic("balloc: out of blocks");
+
+found:
+  acquire(&bsum.lock);
+  bsum.hint = b + *got < sb.size ? b + *got : 0;
+  release(&bsum.lock);
+  for(i = 0; i < *got; i++)
+    bzero(dev, b + i);
+  return b;
+}
+
+// Allocate a zeroed disk block.
+static uint
+balloc(uint dev, uint prev)
+{
+  uint got;
+
+  return ballocrun(dev, prev, 1, &got);
+}
+
+// Free a disk block.
+static void
+bfree(int dev, uint b)
+{
+  struct buf *bp;
+  int bi, m;
+
+  bsumload(dev);
+  bp = bread(dev, BBLOCK(b, sb));
+  bi = b % BPB;
+  m = 1 << (bi % 8);
+  if((bp->data[bi/8] & m) == 0)
+    panic("freeing free block");
+  bp->data[bi/8] &= ~m;
+  log_write(bp);
+  brelse(bp);
+  acquire(&bsum.lock);
+  bsum.nfree[b / BPB]++;
+  release(&bsum.lock);
+}
+
+// Inodes.
+//
+// An inode describes a single unnamed file.
+// The inode disk structure holds metadata: the file's type,
+// its size, the number of links referring to it, and the
+// list of blocks holding the file's content.
+//
+// The inodes are laid out sequentially on disk at
+// sb.startinode. Each inode has a number, indicating its
+// position on the disk.
+//
+// The kernel keeps a cache of in-use inodes in memory
+// to provide a place for synchronizing access
+// to inodes used by multiple processes. The cached
+// inodes include book-keeping information that is
+// not stored on disk: ip->ref and ip->valid.
+//
+// An inode and its in-memory representation go through a
+// sequence of states before they can be used by the
+// rest of the file system code.
+//
+// * Allocation: an inode is allocated if its type (on disk)
+//   is non-zero. ialloc() allocates, and iput() frees if
+//   the reference and link counts have fallen to zero.
+//
+// * Referencing in cache: an entry in the inode cache
+//   is free if ip->ref is zero. Otherwise ip->ref tracks
+//   the number of in-memory pointers to the entry (open
+//   files and current directories). iget() finds or
+//   creates a cache entry and increments its ref; iput()
+//   decrements ref.
+//
+// * Valid: the information (type, size, &c) in an inode
+//   cache entry is only correct when ip->valid is 1.
+//   ilock() reads the inode from
+//   the disk and sets ip->valid, while iput() clears
+//   ip->valid if ip->ref has fallen to zero.
+//
+// * Locked: file system code may only examine and modify
+//   the information in an inode and its content if it
+//   has first locked the inode.
+//
+// Thus a typical sequence is:
+//   ip = iget(dev, inum)
+//   ilock(ip)
+//   ... examine and modify ip->xxx ...
+//   iunlock(ip)
+//   iput(ip)
+//
+// ilock() is separate from iget() so that system calls can
+// get a long-term reference to an inode (as for an open file)
+// and only lock it for short periods (e.g., in read()).
+// The separation also helps avoid deadlock and races during
+// pathname lookup. iget() increments ip->ref so that the inode
+// stays cached and pointers to it remain valid.
+//
+// Many internal file system functions expect the caller to
+// have locked the inodes involved; this lets callers create
+// multi-step atomic operations.
+//
+// The icache.lock spin-lock protects the allocation of icache
+// entries. Since ip->ref indicates whether an entry is free,
+// and ip->dev and ip->inum indicate which i-node an entry
+// holds, one must hold icache.lock while using any of those fields.
+//
+// 추가: 엔트리는 (dev, inum) 해시로 찾음. ref가 0인 엔트리는 내용을
+// 그대로 둔 채 LRU 리스트에 들어가서, 다시 iget되면 디스크를 읽지 않고
+// 재사용되고, 새 inode가 필요하면 가장 오래된 것부터 재활용됨.
+// hnext, lprev, lnext도 icache.lock으로 보호함.
+//
+// An ip->lock sleep-lock protects all ip-> fields other than ref,
+// dev, and inum.  One must hold ip->lock in order to
+// read or write that inode's ip->valid, ip->size, ip->type, &c.
+
+#define NIHASH 31
+#define IHASH(dev, inum) (((dev) * 7 + (inum)) % NIHASH)
+
+struct {
+  struct spinlock lock;
+  struct inode inode[NINODE];
+  struct inode *hash[NIHASH];
+  struct inode lru;  // lru.lnext is the most recently released
+} icache;
+
+// Put ip on the LRU list, at the front or the back.
+// Caller must hold icache.lock.
+static void
+ilruinsert(struct inode *ip, int front)
+{
+  struct inode *at;
+
+  at = front ? &icache.lru : icache.lru.lprev;
+  ip->lnext = at->lnext;
+  ip->lprev = at;
+  at->lnext->lprev = ip;
+  at->lnext = ip;
+}
+
+static void
+ilruremove(struct inode *ip)
+{
+  ip->lprev->lnext = ip->lnext;
+  ip->lnext->lprev = ip->lprev;
+}
+
+// Remove ip from its hash chain, if it is on one.
+static void
+ihashremove(struct inode *ip)
+{
+  struct inode **pp;
+
+  for(pp = &icache.hash[IHASH(ip->dev, ip->inum)]; *pp; pp = &(*pp)->hnext){
+    if(*pp == ip){
+      *pp = ip->hnext;
+      break;
+    }
+  }
+}
+
+// 추가: 디렉터리 엔트리 캐시 (dentry cache).
+// (dev, 디렉터리 inum, 이름) -> inum을 해시로 찾음. inum이 0인 엔트리는
+// "이 이름은 없음"을 기억하는 negative 엔트리.
+// 디렉터리 내용이 바뀌는 dirlink()/dirunlink()가 엔트리를 갱신하고,
+// 디렉터리 inode가 해제되면 그 디렉터리의 엔트리를 모두 지움.
+// 같은 디렉터리에 대한 조회와 변경은 디렉터리의 ip->lock 아래에서만
+// 일어나므로 캐시는 항상 디렉터리 내용과 일치함.
+#define NDENTRY 128
+#define NDHASH  61
+
+struct dentry {
+  uint dev;
+  uint dinum;           // inode number of the directory
+  char name[DIRSIZ];
+  uint inum;            // 0 if name is known to be absent
+  uint off;             // byte offset of the entry in the directory
+  int used;             // clock bit for replacement
+  struct dentry *next;  // hash chain
+};
+
+struct {
+  struct spinlock lock;
+  struct dentry dentry[NDENTRY];
+  struct dentry *hash[NDHASH];
+  int hand;             // clock hand for replacement
+} dcache;
+
+void
+iinit(int dev)
+{
+  int i = 0;
+  
+  initlock(&icache.lock, "icache");
+  icache.lru.lprev = icache.lru.lnext = &icache.lru;
+  for(i = 0; i < NINODE; i++) {
+    initsleeplock(&icache.inode[i].lock, "inode");
+    ilruinsert(&icache.inode[i], 1);
+  }
+  initlock(&dcache.lock, "dcache");
+  initlock(&bsum.lock, "bsum");
+
+  readsb(dev, &sb);
+  cprintf("sb: size %d nblocks %d ninodes %d nlog %d logstart %d\
+ inodestart %d bmap start %d\n", sb.size, sb.nblocks,
+          sb.ninodes, sb.nlog, sb.logstart, sb.inodestart,
+          sb.bmapstart);
+}
+
+static struct inode* iget(uint dev, uint inum);
+
+//PAGEBREAK!
+// Allocate an inode on device dev.
+// Mark it as allocated by  giving it type type.
+// Returns an unlocked but allocated and referenced inode.
+struct inode*
+ialloc(uint dev, short type)
+{
+  int inum;
+  struct buf *bp;
+  struct dinode *dip;
+
+  if(dev == TMPDEV)
+    return iget(dev, tmpialloc(type));
+
+  for(inum = 1; inum < sb.ninodes; inum++){
+    bp = bread(dev, IBLOCK(inum, sb));
+    dip = (struct dinode*)bp->data + inum%IPB;
+    if(dip->type == 0){  // a free inode
+      memset(dip, 0, sizeof(*dip));
+      dip->type = type;
+      log_write(bp);   // mark it allocated on the disk
+      brelse(bp);
+      return iget(dev, inum);
+    }
+    brelse(bp);
+  }
+  panic("ialloc: no inodes");
+}
+
+// Copy a modified in-memory inode to disk.
+// Must be called after every change to an ip->xxx field
+// that lives on disk, since i-node cache is write-through.
+// Caller must hold ip->lock.
+void
+iupdate(struct inode *ip)
+{
+  struct buf *bp;
+  struct dinode *dip;
+
+  if(ip->dev == TMPDEV){
+    tmpiupdate(ip);
+    return;
+  }
+
+  bp = bread(ip->dev, IBLOCK(ip->inum, sb));
+  dip = (struct dinode*)bp->data + ip->inum%IPB;
+  dip->type = ip->type;
+  dip->major = ip->major;
+  dip->minor = ip->minor;
+  dip->nlink = ip->nlink;
+  dip->size = ip->size;
+  memmove(dip->addrs, ip->addrs, sizeof(ip->addrs));
+  log_write(bp);
+  brelse(bp);
+}
+
+// Find the inode with number inum on device dev
+// and return the in-memory copy. Does not lock
+// the inode and does not read it from disk.
+static struct inode*
+iget(uint dev, uint inum)
+{
+  struct inode *ip;
+
+  acquire(&icache.lock);
+
+  // Is the inode already cached?
+  for(ip = icache.hash[IHASH(dev, inum)]; ip; ip = ip->hnext){
+    if(ip->dev == dev && ip->inum == inum){
+      if(ip->ref++ == 0)
+        ilruremove(ip);
+      release(&icache.lock);
+      return ip;
+    }
+  }
+
+  // Recycle the least recently used unreferenced entry.
+  ip = icache.lru.lprev;
+  if(ip == &icache.lru)
+    panic("iget: no inodes");
+  ilruremove(ip);
+  ihashremove(ip);
+
+  ip->dev = dev;
+  ip->inum = inum;
+  ip->ref = 1;
+  ip->valid = 0;
+  ip->hnext = icache.hash[IHASH(dev, inum)];
+  icache.hash[IHASH(dev, inum)] = ip;
+  release(&icache.lock);
+
+  return ip;
+}
+
+// Increment reference count for ip.
+// Returns ip to enable ip = idup(ip1) idiom.
+struct inode*
+idup(struct inode *ip)
+{
+  acquire(&icache.lock);
+  ip->ref++;
+  release(&icache.lock);
+  return ip;
+}
+
+// Lock the given inode.
+// Reads the inode from disk if necessary.
+void
+ilock(struct inode *ip)
+{
+  struct buf *bp;
+  struct dinode *dip;
+
+  if(ip == 0 || ip->ref < 1)
+    panic("ilock");
+
+  acquiresleep(&ip->lock);
+
+  if(ip->valid == 0 && ip->dev == TMPDEV){
+    tmpiload(ip);
+    ip->valid = 1;
+    if(ip->type == 0)
+      panic("ilock: no type");
+  } else if(ip->valid == 0){
+    bp = bread(ip->dev, IBLOCK(ip->inum, sb));
+    dip = (struct dinode*)bp->data + ip->inum%IPB;
+    ip->type = dip->type;
+    ip->major = dip->major;
+    ip->minor = dip->minor;
+    ip->nlink = dip->nlink;
+    ip->size = dip->size;
+    memmove(ip->addrs, dip->addrs, sizeof(ip->addrs));
+    brelse(bp);
+    ip->valid = 1;
+    if(ip->type == 0)
+      panic("ilock: no type");
+  }
+}
+
+// Unlock the given inode.
+void
+iunlock(struct inode *ip)
+{
+  if(ip == 0 || !holdingsleep(&ip->lock) || ip->ref < 1)
+    panic("iunlock");
+
+  releasesleep(&ip->lock);
+}
+
+// Drop a reference to an in-memory inode.
+// If that was the last reference, the inode cache entry can
+// be recycled.
+// If that was the last reference and the inode has no links
+// to it, free the inode (and its content) on disk.
+// All calls to iput() must be inside a transaction in
+// case it has to free the inode.
+void
+iput(struct inode *ip)
+{
+  acquiresleep(&ip->lock);
+  if(ip->valid && ip->nlink == 0){
+    acquire(&icache.lock);
+    int r = ip->ref;
+    release(&icache.lock);
+    if(r == 1){
+      // inode has no links and no other references: truncate and free.
+      if(ip->type == T_DIR)
+        dpurge(ip->dev, ip->inum);
+      itrunc(ip);
+      ip->type = 0;
+      iupdate(ip);
+      ip->valid = 0;
+    }
+  }
+  releasesleep(&ip->lock);
+
+  acquire(&icache.lock);
+  ip->ref--;
+  // 추가: 해제된 inode는 먼저 재활용되도록 LRU 뒤쪽에 넣음
+  if(ip->ref == 0)
+    ilruinsert(ip, ip->valid);
+  release(&icache.lock);
+}
+
+// Common idiom: unlock, then put.
+void
+iunlockput(struct inode *ip)
+{
+  iunlock(ip);
+  iput(ip);
+}
+
+//PAGEBREAK!
+// Inode content
+//
+// The content (data) associated with each inode is stored
+// in blocks on the disk. The first NDIRECT block numbers
+// are listed in ip->addrs[].  The next NINDIRECT blocks are
+// listed in block ip->addrs[NDIRECT].  The last NDINDIRECT blocks
+// are listed in the NINDIRECT blocks listed in ip->addrs[NDIRECT+1].
+
+// Return the disk block address of the nth block in inode ip.
+// If there is no such block, bmap allocates one.
+// 추가: bmapat은 blk가 0이 아니면 새로 할당하는 대신 blk를 그 자리에 씀.
+static uint bmapat(struct inode*, uint, uint);
+
+static uint
+bmap(struct inode *ip, uint bn)
+{
+  return bmapat(ip, bn, 0);
+}
+
+static uint
+bmapat(struct inode *ip, uint bn, uint blk)
+{
+  uint addr, *a;
+  struct buf *bp;
+
+  // 추가: 새 블록은 파일의 바로 앞 블록(또는 그 블록을 가리키는
+  // 간접 블록) 다음 자리에 오도록 balloc에 알려 줌.
+  if(bn < NDIRECT){
+    if((addr = ip->addrs[bn]) == 0)
+      ip->addrs[bn] = addr = blk ? blk : balloc(ip->dev, bn > 0 ? ip->addrs[bn-1] : 0);
+    return addr;
+  }
+  bn -= NDIRECT;
+
+  if(bn < NINDIRECT){
+    // Load indirect block, allocating if necessary.
+    if((addr = ip->addrs[NDIRECT]) == 0)
+      ip->addrs[NDIRECT] = addr = balloc(ip->dev, ip->addrs[NDIRECT-1]);
+    bp = bread(ip->dev, addr);
+    a = (uint*)bp->data;
+    if((addr = a[bn]) == 0){
+      a[bn] = addr = blk ? blk : balloc(ip->dev, bn > 0 ? a[bn-1] : bp->blockno);
+      log_write(bp);
+    }
+    brelse(bp);
+    return addr;
+  }
+  bn -= NINDIRECT;
+
+  // 추가: 이중 간접 블록
+  if(bn < NDINDIRECT){
+    if((addr = ip->addrs[NDIRECT+1]) == 0)
+      ip->addrs[NDIRECT+1] = addr = balloc(ip->dev, 0);
+    bp = bread(ip->dev, addr);
+    a = (uint*)bp->data;
+    if((addr = a[bn / NINDIRECT]) == 0){
+      a[bn / NINDIRECT] = addr = balloc(ip->dev, 0);
+      log_write(bp);
+    }
+    brelse(bp);
+
+    bp = bread(ip->dev, addr);
+    a = (uint*)bp->data;
+    if((addr = a[bn % NINDIRECT]) == 0){
+      a[bn % NINDIRECT] = addr = blk ? blk :
+        balloc(ip->dev, bn % NINDIRECT > 0 ? a[bn % NINDIRECT - 1] : bp->blockno);
+      log_write(bp);
+    }
+    brelse(bp);
+    return addr;
+  }
+
+  panic("bmap: out of range");
+}
+
+// Truncate inode (discard contents).
+// Only called when the inode has no links
+// to it (no directory entries referring to it)
+// and has no in-memory reference to it (is
+// not an open file or current directory).
+static void
+itrunc(struct inode *ip)
+{
+  ishrink(ip, 0);
+}
+
+// 추가: nb번째 블록부터 끝까지 해제함. 일부만 비우는 간접 블록은
+// 해제한 항목을 0으로 고쳐서 기록하고, 통째로 비는 간접 블록은 해제함.
+// Caller must hold ip->lock and be in a transaction.
+static void
+ifree(struct inode *ip, uint nb)
+{
+  int i, j, k;
+  struct buf *bp, *bp2;
+  uint *a, *a2, first, sub;
+
+  for(i = nb; i < NDIRECT; i++){
+    if(ip->addrs[i]){
+      bfree(ip->dev, ip->addrs[i]);
+      ip->addrs[i] = 0;
+    }
+  }
+
+  first = nb > NDIRECT ? nb - NDIRECT : 0;
+  if(ip->addrs[NDIRECT] && first < NINDIRECT){
+    bp = bread(ip->dev, ip->addrs[NDIRECT]);
+    a = (uint*)bp->data;
+    for(j = first; j < NINDIRECT; j++){
+      if(a[j]){
+        bfree(ip->dev, a[j]);
+        a[j] = 0;
+      }
+    }
+    if(first > 0)
+      log_write(bp);
+    brelse(bp);
+    if(first == 0){
+      bfree(ip->dev, ip->addrs[NDIRECT]);
+      ip->addrs[NDIRECT] = 0;
+    }
+  }
+
+  // 추가: 이중 간접 블록
+  first = nb > NDIRECT + NINDIRECT ? nb - NDIRECT - NINDIRECT : 0;
+  if(ip->addrs[NDIRECT+1]){
+    bp = bread(ip->dev, ip->addrs[NDIRECT+1]);
+    a = (uint*)bp->data;
+    for(j = first / NINDIRECT; j < NINDIRECT; j++){
+      if(a[j] == 0)
+        continue;
+      sub = j == first / NINDIRECT ? first % NINDIRECT : 0;
+      bp2 = bread(ip->dev, a[j]);
+      a2 = (uint*)bp2->data;
+      for(k = sub; k < NINDIRECT; k++){
+        if(a2[k]){
+          bfree(ip->dev, a2[k]);
+          a2[k] = 0;
+        }
+      }
+      if(sub > 0)
+        log_write(bp2);
+      brelse(bp2);
+      if(sub == 0){
+        bfree(ip->dev, a[j]);
+        a[j] = 0;
+      }
+    }
+    if(first > 0)
+      log_write(bp);
+    brelse(bp);
+    if(first == 0){
+      bfree(ip->dev, ip->addrs[NDIRECT+1]);
+      ip->addrs[NDIRECT+1] = 0;
+    }
+  }
+}
+
+// 추가: 파일을 size 바이트로 줄임. 남는 블록의 size 이후 부분은
+// 나중에 다시 늘렸을 때 0으로 읽히도록 지움.
+// Caller must hold ip->lock and be in a transaction.
+void
+ishrink(struct inode *ip, uint size)
+{
+  struct buf *bp;
+
+  if(size > ip->size)
+    return;
+  if(ip->dev == TMPDEV){
+    tmpitrunc(ip, size);
+    ip->size = size;
+    iupdate(ip);
+    return;
+  }
+  ifree(ip, (size + BSIZE - 1) / BSIZE);
+  if(size % BSIZE){
+    bp = bread(ip->dev, bmap(ip, size / BSIZE));
+    memset(bp->data + size % BSIZE, 0, BSIZE - size % BSIZE);
+    log_write(bp);
+    brelse(bp);
+  }
+  ip->size = size;
+  iupdate(ip);
+}
+
+// 추가: 파일이 end 바이트까지 블록을 갖도록 늘림. 새 블록은 ballocrun으로
+// 파일의 마지막 블록 뒤에 이어지는 extent 단위로 할당함.
+// 한 번에 최대 max개 블록만 할당하고, 늘어난 뒤의 크기를 반환함.
+// 이 파일 시스템의 파일에는 구멍이 없으므로 size까지의 블록은 모두 있음.
+// Caller must hold ip->lock and be in a transaction.
+int
+igrow(struct inode *ip, uint end, uint max)
+{
+  uint nb, nend, blk, got;
+
+  if(ip->type != T_FILE)
+    return -1;
+  if(ip->dev == TMPDEV)
+    return tmpigrow(ip, end);
+  if(end > MAXFILE*BSIZE)
+    return -1;
+  if(end <= ip->size)
+    return ip->size;
+
+  nb = (ip->size + BSIZE - 1) / BSIZE;
+  nend = (end + BSIZE - 1) / BSIZE;
+  if(nend - nb > max){
+    nend = nb + max;
+    end = nend * BSIZE;
+  }
+  while(nb < nend){
+    blk = ballocrun(ip->dev, nb > 0 ? bmap(ip, nb - 1) : 0, nend - nb, &got);
+    for(; got > 0; got--, nb++, blk++)
+      if(bmapat(ip, nb, blk) != blk)
+        panic("igrow");
+  }
+  ip->size = end;
+  iupdate(ip);
+  return end;
+}
+
+// Copy stat information from inode.
+// Caller must hold ip->lock.
+void
+stati(struct inode *ip, struct stat *st)
+{
+  st->dev = ip->dev;
+  st->ino = ip->inum;
+  st->type = ip->type;
+  st->nlink = ip->nlink;
+  st->size = ip->size;
+}
+
+//PAGEBREAK!
+// Read data from inode.
+// Caller must hold ip->lock.
+int
+readi(struct inode *ip, char *dst, uint off, uint n)
+{
+  uint tot, m;
+  struct buf *bp;
+
+  if(ip->type == T_DEV){
+    if(ip->major < 0 || ip->major >= NDEV || !devsw[ip->major].read)
+      return -1;
+    return devsw[ip->major].read(ip, dst, n);
+  }
+  if(ip->dev == TMPDEV)
+    return tmpreadi(ip, dst, off, n);
+
+  if(off > ip->size || off + n < off)
+    return -1;
+  if(off + n > ip->size)
+    n = ip->size - off;
+
+  for(tot=0; tot<n; tot+=m, off+=m, dst+=m){
+    bp = bread(ip->dev, bmap(ip, off/BSIZE));
+    m = min(n - tot, BSIZE - off%BSIZE);
+    memmove(dst, bp->data + off%BSIZE, m);
+    brelse(bp);
+  }
+  return n;
+}
+
+// 추가: 순차 읽기 readahead.
+// off부터 n바이트에 해당하는 블록들을 비동기로 읽어 둠.
+// 파일 크기 안의 블록은 이미 할당되어 있으므로 bmap이 새 블록을 할당하지 않음.
+// 빈 버퍼가 모자라 중간에 멈추면 -1.
+// Caller must hold ip->lock.
+int
+readahead(struct inode *ip, uint off, uint n)
+{
+  uint bn, end;
+
+  if(ip->type == T_DEV || ip->dev == TMPDEV || off >= ip->size)
+    return 0;
+  if(off + n > ip->size || off + n < off)
+    n = ip->size - off;
+
+  end = (off + n + BSIZE - 1) / BSIZE;
+  for(bn = off / BSIZE; bn < end; bn++)
+    if(breadahead(ip->dev, bmap(ip, bn)) < 0)
+      return -1;
+  return 0;
+}
+
+// PAGEBREAK!
+// Write data to inode.
+// Caller must hold ip->lock.
+int
+writei(struct inode *ip, char *src, uint off, uint n)
+{
+  uint tot, m;
+  struct buf *bp;
+
+  if(ip->type == T_DEV){
+    if(ip->major < 0 || ip->major >= NDEV || !devsw[ip->major].write)
+      return -1;
+    return devsw[ip->major].write(ip, src, n);
+  }
+  if(ip->dev == TMPDEV)
+    return tmpwritei(ip, src, off, n);
+
+  if(off > ip->size || off + n < off)
+    return -1;
+  if(off + n > MAXFILE*BSIZE)
+    return -1;
+
+  for(tot=0; tot<n; tot+=m, off+=m, src+=m){
+    bp = bread(ip->dev, bmap(ip, off/BSIZE));
+    m = min(n - tot, BSIZE - off%BSIZE);
+    memmove(bp->data + off%BSIZE, src, m);
+    log_write(bp);
+    brelse(bp);
+  }
+
+  if(n > 0 && off > ip->size){
+    ip->size = off;
+    iupdate(ip);
+  }
+  return n;
+}
+
+// 추가: src의 soff부터 n바이트를 dst의 doff로 버퍼 캐시 블록끼리 바로 복사함.
+// 사용자 버퍼를 거치지 않음. 같은 파일 안에서 겹치는 범위는 허용하지 않음.
+// Caller must hold both locks and be inside a transaction.
+int
+copyi(struct inode *src, uint soff, struct inode *dst, uint doff, uint n)
+{
+  uint tot, m, sb, db;
+  struct buf *sbp, *dbp;
+
+  if(src->type != T_FILE || dst->type != T_FILE)
+    return -1;
+  // tmpfs has no buffer-cache blocks to copy between.
+  if(src->dev == TMPDEV || dst->dev == TMPDEV)
+    return -1;
+  if(soff > src->size || soff + n < soff)
+    return -1;
+  if(soff + n > src->size)
+    n = src->size - soff;
+  if(doff > dst->size || doff + n < doff)
+    return -1;
+  if(doff + n > MAXFILE*BSIZE)
+    return -1;
+  if(src == dst && soff < doff + n && doff < soff + n)
+    return -1;
+
+  for(tot=0; tot<n; tot+=m, soff+=m, doff+=m){
+    m = min(n - tot, BSIZE - soff%BSIZE);
+    m = min(m, BSIZE - doff%BSIZE);
+    sb = bmap(src, soff/BSIZE);
+    db = bmap(dst, doff/BSIZE);
+    dbp = bread(dst->dev, db);
+    if(src->dev == dst->dev && sb == db){
+      memmove(dbp->data + doff%BSIZE, dbp->data + soff%BSIZE, m);
+    } else {
+      sbp = bread(src->dev, sb);
+      memmove(dbp->data + doff%BSIZE, sbp->data + soff%BSIZE, m);
+      brelse(sbp);
+    }
+    log_write(dbp);
+    brelse(dbp);
+  }
+
+  if(n > 0 && doff > dst->size){
+    dst->size = doff;
+    iupdate(dst);
+  }
+  return n;
+}
+
+//PAGEBREAK!
+// Directories
+
+int
+namecmp(const char *s, const char *t)
+{
+  return strncmp(s, t, DIRSIZ);
+}
+
+// 추가: dentry cache
+static struct dentry**
+dhash(uint dev, uint dinum, char *name)
+{
+  uint h;
+  int i;
+
+  h = dev * 31 + dinum;
+  for(i = 0; i < DIRSIZ && name[i]; i++)
+    h = h * 31 + (uchar)name[i];
+  return &dcache.hash[h % NDHASH];
+}
+
+// Find the cached entry for name in directory (dev, dinum).
+// Caller must hold dcache.lock.
+static struct dentry*
+dfind(uint dev, uint dinum, char *name)
+{
+  struct dentry *d;
+
+  for(d = *dhash(dev, dinum, name); d; d = d->next){
+    if(d->dev == dev && d->dinum == dinum && namecmp(name, d->name) == 0)
+      return d;
+  }
+  return 0;
+}
+
+// Remove d from its hash chain.  Caller must hold dcache.lock.
+static void
+dunhash(struct dentry *d)
+{
+  struct dentry **pp;
+
+  for(pp = dhash(d->dev, d->dinum, d->name); *pp; pp = &(*pp)->next){
+    if(*pp == d){
+      *pp = d->next;
+      break;
+    }
+  }
+  d->dev = 0;
+}
+
+// Record that name in directory dp is inode inum at offset off
+// (inum 0: name is absent).  Caller must hold dp->lock.
+static void
+dset(struct inode *dp, char *name, uint inum, uint off)
+{
+  struct dentry *d, **pp;
+
+  acquire(&dcache.lock);
+  if((d = dfind(dp->dev, dp->inum, name)) == 0){
+    // Recycle an entry that has not been used since the hand last passed.
+    for(;;){
+      d = &dcache.dentry[dcache.hand];
+      dcache.hand = (dcache.hand + 1) % NDENTRY;
+      if(d->dev == 0 || !d->used)
+        break;
+      d->used = 0;
+    }
+    if(d->dev != 0)
+      dunhash(d);
+    d->dev = dp->dev;
+    d->dinum = dp->inum;
+    strncpy(d->name, name, DIRSIZ);
+    pp = dhash(d->dev, d->dinum, d->name);
+    d->next = *pp;
+    *pp = d;
+  }
+  d->inum = inum;
+  d->off = off;
+  d->used = 1;
+  release(&dcache.lock);
+}
+
+// Forget every entry of directory (dev, dinum), which is being freed.
+static void
+dpurge(uint dev, uint dinum)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  for(d = dcache.dentry; d < &dcache.dentry[NDENTRY]; d++){
+    if(d->dev == dev && d->dinum == dinum)
+      dunhash(d);
+  }
+  release(&dcache.lock);
+}
+
+// Look for a directory entry in a directory.
+// If found, set *poff to byte offset of entry.
+struct inode*
+dirlookup(struct inode *dp, char *name, uint *poff)
+{
+  uint off, inum;
+  struct dirent de;
+  struct dentry *d;
+
+  if(dp->type != T_DIR)
+    panic("dirlookup not DIR");
+
+  // 추가: 캐시에 있으면 디렉터리 블록을 읽지 않음
+  acquire(&dcache.lock);
+  if((d = dfind(dp->dev, dp->inum, name)) != 0){
+    d->used = 1;
+    inum = d->inum;
+    off = d->off;
+    release(&dcache.lock);
+    if(inum == 0)
+      return 0;
+    if(poff)
+      *poff = off;
+    return iget(dp->dev, inum);
+  }
+  release(&dcache.lock);
+
+  for(off = 0; off < dp->size; off += sizeof(de)){
+    if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+      panic("dirlookup read");
+    if(de.inum == 0)
+      continue;
+    if(namecmp(name, de.name) == 0){
+      // entry matches path element
+      if(poff)
+        *poff = off;
+      inum = de.inum;
+      dset(dp, name, inum, off);
+      return iget(dp->dev, inum);
+    }
+  }
+
+  dset(dp, name, 0, 0);
+  return 0;
+}
+
+// Write a new directory entry (name, inum) into the directory dp.
+int
+dirlink(struct inode *dp, char *name, uint inum)
+{
+  int off;
+  struct dirent de;
+  struct inode *ip;
+
+  // Check that name is not present.
+  if((ip = dirlookup(dp, name, 0)) != 0){
+    iput(ip);
+    return -1;
+  }
+
+  // Look for an empty dirent.
+  for(off = 0; off < dp->size; off += sizeof(de)){
+    if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+      panic("dirlink read");
+    if(de.inum == 0)
+      break;
+  }
+
+  strncpy(de.name, name, DIRSIZ);
+  de.inum = inum;
+  if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+    panic("dirlink");
+  dset(dp, name, inum, off);
+
+  return 0;
+}
+
+// 추가: 디렉터리 dp의 off 위치에 있는 엔트리 name을 지움.
+// Caller must hold dp->lock.
+void
+dirunlink(struct inode *dp, char *name, uint off)
+{
+  struct dirent de;
+
+  memset(&de, 0, sizeof(de));
+  if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+    panic("dirunlink: writei");
+  dset(dp, name, 0, 0);
+}
+
+//PAGEBREAK!
+// Paths
+
+// Copy the next path element from path into name.
+// Return a pointer to the element following the copied one.
+// The returned path has no leading slashes,
+// so the caller can check *path=='\0' to see if the name is the last one.
+// If no name to remove, return 0.
+//
+// Examples:
+//   skipelem("a/bb/c", name) = "bb/c", setting name = "a"
+//   skipelem("///a//bb", name) = "bb", setting name = "a"
+//   skipelem("a", name) = "", setting name = "a"
+//   skipelem("", name) = skipelem("////", name) = 0
+//
+static char*
+skipelem(char *path, char *name)
+{
+  char *s;
+  int len;
+
+  while(*path == '/')
+    path++;
+  if(*path == 0)
+    return 0;
+  s = path;
+  while(*path != '/' && *path != 0)
+    path++;
+  len = path - s;
+  if(len >= DIRSIZ)
+    memmove(name, s, DIRSIZ);
+  else {
+    memmove(name, s, len);
+    name[len] = 0;
+  }
+  while(*path == '/')
+    path++;
+  return path;
+}
+
+// 추가: 마운트 지점. 디스크 루트의 "tmp"는 tmpfs의 루트로,
+// tmpfs 루트의 ".."은 디스크 루트로 넘어감. dp는 잠겨 있어야 함.
+// 해당하지 않으면 0을 반환함.
+static struct inode*
+mountcross(struct inode *dp, char *name)
+{
+  if(dp->dev == ROOTDEV && dp->inum == ROOTINO && namecmp(name, "tmp") == 0)
+    return iget(TMPDEV, ROOTINO);
+  if(dp->dev == TMPDEV && dp->inum == ROOTINO && namecmp(name, "..") == 0)
+    return iget(ROOTDEV, ROOTINO);
+  return 0;
+}
+
+// Look up and return the inode for a path name.
+// If parent != 0, return the inode for the parent and copy the final
+// path element into name, which must have room for DIRSIZ bytes.
+// Must be called inside a transaction since it calls iput().
+static struct inode*
+namex(char *path, int nameiparent, char *name)
+{
+  struct inode *ip, *next;
+
+  if(*path == '/')
+    ip = iget(ROOTDEV, ROOTINO);
+  else
+    ip = idup(myproc()->cwd);
+
+  while((path = skipelem(path, name)) != 0){
+    ilock(ip);
+    if(ip->type != T_DIR){
+      iunlockput(ip);
+      return 0;
+    }
+    if(nameiparent && *path == '\0'){
+      // Stop one level early.
+      iunlock(ip);
+      return ip;
+    }
+    if((next = mountcross(ip, name)) == 0 &&
+       (next = dirlookup(ip, name, 0)) == 0){
+      iunlockput(ip);
+      return 0;
+    }
+    iunlockput(ip);
+    ip = next;
+  }
+  if(nameiparent){
+    iput(ip);
+    return 0;
+  }
+  return ip;
+}
+
+struct inode*
+namei(char *path)
+{
+  char name[DIRSIZ];
+  return namex(path, 0, name);
+}
+
+struct inode*
+nameiparent(char *path, char *name)
+{
+  return namex(path, 1, name);
+}
@@ -0,0 +1,202 @@
+// 파일 I/O 벤치마크 (#1의 lseektest에서 출발).
+// 순차/랜덤 읽기와 쓰기, 여러 블록 크기, lseek+read와 pread와 uring 비교,
+// 파일을 늘리는 여러 방법을 각각 uptime()으로 재서 MB/s와 ops/s로 출력함.
+// 사용법: fsbench [파일 크기(KB)]
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "uring.h"
+
+#define FILENAME "benchfile"
+#define MAXBS    16384
+
+char buf[MAXBS];
+int filesz = 1024 * 1024;
+uint seed = 1;
+
+void _error(const char *msg) {
+    printf(1, "%s\nfsbench failed...\n", msg);
+    unlink(FILENAME);
+    exit();
+}
+
+uint rnd(void) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// bytes를 ops번에 나눠 ticks 동안 옮긴 결과를 출력함.
+// xv6의 printf는 소수를 못 찍으므로 MB/s는 정수로 계산해서 소수 둘째 자리까지 찍음.
+void report(char *name, int bs, int bytes, int ops, int ticks) {
+    int kb, mb100;
+
+    if (ticks <= 0)
+        ticks = 1;  // 한 tick(10ms)보다 짧게 끝남
+    kb = bytes / 1024;
+    mb100 = kb * 100 * 100 / 1024 / ticks;
+    printf(1, "%s bs %d: %d KB in %d ticks, %d.%d%d MB/s, %d ops/s\n",
+           name, bs, kb, ticks, mb100 / 100, mb100 / 10 % 10, mb100 % 10,
+           ops * 100 / ticks);
+}
+
+// 빈 파일을 새로 엶
+int openempty(void) {
+    int fd;
+
+    if ((fd = open(FILENAME, O_CREATE | O_RDWR)) < 0)
+        _error("Open error");
+    if (ftruncate(fd, 0) < 0)
+        _error("ftruncate error");
+    return fd;
+}
+
+void seqwrite(int bs) {
+    int fd, i, t0;
+
+    fd = openempty();
+    t0 = uptime();
+    for (i = 0; i < filesz; i += bs)
+        if (write(fd, buf, bs) != bs)
+            _error("Write error");
+    report("seq write    ", bs, filesz, filesz / bs, uptime() - t0);
+    close(fd);
+}
+
+void seqread(int bs) {
+    int fd, i, t0;
+
+    if ((fd = open(FILENAME, O_RDONLY)) < 0)
+        _error("Open error");
+    t0 = uptime();
+    for (i = 0; i < filesz; i += bs)
+        if (read(fd, buf, bs) != bs)
+            _error("Read error");
+    report("seq read     ", bs, filesz, filesz / bs, uptime() - t0);
+    close(fd);
+}
+
+// 랜덤 오프셋 I/O. positional이면 pread/pwrite, 아니면 lseek 후 read/write.
+void randio(int bs, int iswrite, int positional) {
+    int fd, i, n, off, t0, r;
+    char *name;
+
+    if ((fd = open(FILENAME, O_RDWR)) < 0)
+        _error("Open error");
+    n = filesz / bs;
+    seed = 1;
+    t0 = uptime();
+    for (i = 0; i < n; i++) {
+        off = (rnd() % n) * bs;
+        if (positional) {
+            r = iswrite ? pwrite(fd, buf, bs, off) : pread(fd, buf, bs, off);
+        } else {
+            if (lseek(fd, off, SEEK_SET) != off)
+                _error("lseek error");
+            r = iswrite ? write(fd, buf, bs) : read(fd, buf, bs);
+        }
+        if (r != bs)
+            _error(iswrite ? "Write error" : "Read error");
+    }
+    if (iswrite)
+        name = positional ? "rand pwrite  " : "rand lseek+wr";
+    else
+        name = positional ? "rand pread   " : "rand lseek+rd";
+    report(name, bs, filesz, n, uptime() - t0);
+    close(fd);
+}
+
+// 랜덤 오프셋 I/O를 uring으로 한 번에 URING_SQSIZE개씩 제출함.
+// randio(.., 1)과 같은 오프셋 순서라 시스템 콜 횟수만 다름.
+void randuring(int bs, int iswrite) {
+    static struct uring *r;
+    struct uring_sqe *e;
+    int fd, i, k, n, t0;
+
+    if (r == 0 && (r = uring_setup()) == (struct uring *)-1)
+        _error("uring_setup error");
+    if ((fd = open(FILENAME, O_RDWR)) < 0)
+        _error("Open error");
+    n = filesz / bs;
+    seed = 1;
+    t0 = uptime();
+    for (i = 0; i < n; i += k) {
+        for (k = 0; k < URING_SQSIZE && i + k < n; k++) {
+            e = &r->sq[r->sqtail % URING_SQSIZE];
+            e->op = iswrite ? URING_WRITE : URING_READ;
+            e->fd = fd;
+            e->addr = buf;
+            e->n = bs;
+            e->off = (rnd() % n) * bs;
+            e->user_data = i + k;
+            r->sqtail++;
+        }
+        if (uring_enter(k, k) != k)
+            _error("uring_enter error");
+        for (; r->cqhead != r->cqtail; r->cqhead++)
+            if (r->cq[r->cqhead % URING_CQSIZE].res != bs)
+                _error(iswrite ? "Write error" : "Read error");
+    }
+    report(iswrite ? "rand uring wr" : "rand uring rd", bs, filesz, n, uptime() - t0);
+    close(fd);
+}
+
+// 파일을 filesz까지 늘리는 방법 비교.
+// 0: write로 덧붙이기, 1: fallocate 후 덮어쓰기,
+// 2: ftruncate 후 덮어쓰기, 3: lseek로 끝 너머로 옮긴 뒤 덮어쓰기
+void extend(int how) {
+    static char *names[] = {
+        "ext append   ", "ext fallocate", "ext ftruncate", "ext lseek    ",
+    };
+    int fd, i, t0, bs;
+
+    bs = 4096;
+    fd = openempty();
+    t0 = uptime();
+    if (how == 1 && fallocate(fd, 0, filesz) < 0)
+        _error("fallocate error");
+    if (how == 2 && ftruncate(fd, filesz) < 0)
+        _error("ftruncate error");
+    if (how == 3 && (lseek(fd, filesz, SEEK_SET) != filesz || lseek(fd, 0, SEEK_SET) != 0))
+        _error("lseek error");
+    for (i = 0; i < filesz; i += bs)
+        if (write(fd, buf, bs) != bs)
+            _error("Write error");
+    report(names[how], bs, filesz, filesz / bs, uptime() - t0);
+    close(fd);
+}
+
+int main(int argc, char *argv[]) {
+    static int bss[] = { 512, 4096, MAXBS };
+    int i;
+
+    if (argc > 1)
+        filesz = atoi(argv[1]) * 1024;
+    if (filesz < MAXBS)
+        filesz = MAXBS;
+    filesz -= filesz % MAXBS;
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (char)i;
+
+    printf(1, "### fsbench: file size %d KB\n", filesz / 1024);
+
+    for (i = 0; i < 3; i++) {
+        seqwrite(bss[i]);
+        seqread(bss[i]);
+    }
+    for (i = 0; i < 2; i++) {
+        randio(bss[i], 0, 0);
+        randio(bss[i], 0, 1);
+        randio(bss[i], 1, 0);
+        randio(bss[i], 1, 1);
+        randuring(bss[i], 0);
+        randuring(bss[i], 1);
+    }
+    for (i = 0; i < 4; i++)
+        extend(i);
+
+    unlink(FILENAME);
+    printf(1, "### fsbench done\n");
+    exit();
+}
@@ -0,0 +1,358 @@
+// IDE driver code.
+// 추가: QEMU의 PIIX IDE 컨트롤러가 있으면 bus master DMA로 전송하고,
+// 없으면 원래처럼 PIO로 한 블록씩 전송함.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "x86.h"
+#include "traps.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+
+#define SECTOR_SIZE   512
+#define IDE_BSY       0x80
+#define IDE_DRDY      0x40
+#define IDE_DF        0x20
+#define IDE_ERR       0x01
+
+#define IDE_CMD_READ  0x20
+#define IDE_CMD_WRITE 0x30
+#define IDE_CMD_RDMUL 0xc4
+#define IDE_CMD_WRMUL 0xc5
+#define IDE_CMD_RDDMA 0xc8
+#define IDE_CMD_WRDMA 0xca
+
+// Bus master IDE registers (primary channel), relative to bmbase.
+#define BM_CMD        0
+#define BM_STATUS     2
+#define BM_PRDT       4
+#define BM_CMD_START  0x01
+#define BM_CMD_READ   0x08  // device to memory
+#define BM_ST_ERR     0x02
+#define BM_ST_INTR    0x04
+
+#define IDE_MAXBATCH  32    // max blocks merged into one transfer
+
+// Physical region descriptor: one physically contiguous piece
+// of a DMA transfer.  It must not cross a 64KB boundary.
+struct prd {
+  uint addr;
+  ushort count;   // bytes
+  ushort flags;
+};
+#define PRD_EOT 0x8000      // last entry of the table
+
+// idequeue holds the bufs waiting for the disk, sorted by
+// (dev, blockno).  ideactive is the batch of bufs now being
+// read/written to the disk, consecutive blocks linked through qnext.
+// The next batch starts at the first queued block at or after
+// (idedev, idenextblk), wrapping around to the lowest one, so the
+// disk sweeps across the queue in one direction (elevator).
+// You must hold idelock while manipulating queue.
+
+static struct spinlock idelock;
+static struct buf *idequeue;
+static struct buf *ideactive;
+static uint idedev, idenextblk;
+
+static int havedisk1;
+static uint bmbase;  // bus master I/O base; 0 if DMA is unavailable
+// A buf's data may cross a 64KB boundary, so allow two entries per buf.
+static struct prd prdt[IDE_MAXBATCH*2] __attribute__((aligned(512)));
+static void idestart(struct buf*);
+
+// Wait for IDE disk to become ready.
+static int
+idewait(int checkerr)
+{
+  int r;
+
+  while(((r = inb(0x1f7)) & (IDE_BSY|IDE_DRDY)) != IDE_DRDY)
+    ;
+  if(checkerr && (r & (IDE_DF|IDE_ERR)) != 0)
+    return -1;
+  return 0;
+}
+
+// Find the PIIX3/PIIX4 IDE function and enable bus mastering.
+static void
+idedmainit(void)
+{
+  int addr;
+
+  if((addr = pcifind(0x8086, 0x7010)) < 0 &&
+     (addr = pcifind(0x8086, 0x7111)) < 0)
+    return;
+  // BAR4 is the bus master I/O base.
+  bmbase = pciread(addr, 0x20) & 0xfffc;
+  if(bmbase == 0)
+    return;
+  // Enable I/O space and bus master.
+  pciwrite(addr, 0x04, (pciread(addr, 0x04) & 0xffff) | 0x5);
+}
+
+void
+ideinit(void)
+{
+  int i;
+
+  initlock(&idelock, "ide");
+  ioapicenable(IRQ_IDE, ncpu - 1);
+  idewait(0);
+
+  // Check if disk 1 is present
+  outb(0x1f6, 0xe0 | (1<<4));
+  for(i=0; i<1000; i++){
+    if(inb(0x1f7) != 0){
+      havedisk1 = 1;
+      break;
+    }
+  }
+
+  // Switch back to disk 0.
+  outb(0x1f6, 0xe0 | (0<<4));
+
+  idedmainit();
+}
+
+// Fill the PRD table with the data of every buf in batch b.
+static void
+prdfill(struct buf *b)
+{
+  struct prd *p;
+  uint pa, n, left;
+
+  p = prdt;
+  for(; b; b = b->qnext){
+    pa = V2P(b->data);
+    for(left = BSIZE; left > 0; left -= n, pa += n){
+      n = 0x10000 - (pa & 0xffff);
+      if(n > left)
+        n = left;
+      p->addr = pa;
+      p->count = n;
+      p->flags = 0;
+      p++;
+    }
+  }
+  p[-1].flags = PRD_EOT;
+}
+
+// Start the request for batch b.  Caller must hold idelock.
+static void
+idestart(struct buf *b)
+{
+  struct buf *q;
+  int n, dir;
+
+  if(b == 0)
+    panic("idestart");
+  if(b->blockno >= FSSIZE)
+    panic("incorrect blockno");
+  int sector_per_block =  BSIZE/SECTOR_SIZE;
+  int sector = b->blockno * sector_per_block;
+  int read_cmd = (sector_per_block == 1) ? IDE_CMD_READ :  IDE_CMD_RDMUL;
+  int write_cmd = (sector_per_block == 1) ? IDE_CMD_WRITE : IDE_CMD_WRMUL;
+
+  if (sector_per_block > 7) panic("idestart");
+
+  for(n = 0, q = b; q; q = q->qnext)
+    n++;
+
+  idewait(0);
+  outb(0x3f6, 0);  // generate interrupt
+  outb(0x1f2, n * sector_per_block);  // number of sectors
+  outb(0x1f3, sector & 0xff);
+  outb(0x1f4, (sector >> 8) & 0xff);
+  outb(0x1f5, (sector >> 16) & 0xff);
+  outb(0x1f6, 0xe0 | ((b->dev&1)<<4) | ((sector>>24)&0x0f));
+  if(bmbase){
+    // Point the bus master at the PRD table, give the drive
+    // its command, then start the bus master.
+    dir = (b->flags & B_DIRTY) ? 0 : BM_CMD_READ;
+    prdfill(b);
+    outl(bmbase + BM_PRDT, V2P(prdt));
+    outb(bmbase + BM_CMD, dir);
+    outb(bmbase + BM_STATUS, inb(bmbase + BM_STATUS) | BM_ST_ERR | BM_ST_INTR);
+    outb(0x1f7, (b->flags & B_DIRTY) ? IDE_CMD_WRDMA : IDE_CMD_RDDMA);
+    outb(bmbase + BM_CMD, dir | BM_CMD_START);
+  } else if(b->flags & B_DIRTY){
+    outb(0x1f7, write_cmd);
+    outsl(0x1f0, b->data, BSIZE/4);
+  } else {
+    outb(0x1f7, read_cmd);
+  }
+}
+
+// Is buf a ordered before block blockno on device dev?
+static int
+idebefore(struct buf *a, uint dev, uint blockno)
+{
+  return a->dev < dev || (a->dev == dev && a->blockno < blockno);
+}
+
+// Insert b into idequeue, keeping it sorted.
+// Caller must hold idelock.
+static void
+ideinsert(struct buf *b)
+{
+  struct buf **pp;
+
+  for(pp=&idequeue; *pp && !idebefore(b, (*pp)->dev, (*pp)->blockno); pp=&(*pp)->qnext)
+    ;
+  b->qnext = *pp;
+  *pp = b;
+}
+
+// Pick the next request in elevator order, merge it with the
+// queued requests for the blocks right after it in the same
+// direction, and start the batch.  Caller must hold idelock.
+static void
+idenext(void)
+{
+  struct buf **pp, *b, *last;
+  int n;
+
+  if(ideactive != 0 || idequeue == 0)
+    return;
+
+  for(pp=&idequeue; *pp && idebefore(*pp, idedev, idenextblk); pp=&(*pp)->qnext)
+    ;
+  if(*pp == 0)
+    pp = &idequeue;
+
+  // Only DMA can move more than one block per command.
+  b = last = *pp;
+  for(n = 1; bmbase && n < IDE_MAXBATCH; n++){
+    if(last->qnext == 0 || last->qnext->dev != b->dev ||
+       last->qnext->blockno != last->blockno + 1 ||
+       (last->qnext->flags & B_DIRTY) != (b->flags & B_DIRTY))
+      break;
+    last = last->qnext;
+  }
+  *pp = last->qnext;
+  last->qnext = 0;
+
+  ideactive = b;
+  idedev = b->dev;
+  idenextblk = last->blockno + 1;
+  idestart(b);
+}
+
+// Interrupt handler.
+void
+ideintr(void)
+{
+  struct buf *b, *next;
+  int st;
+
+  acquire(&idelock);
+
+  if((b = ideactive) == 0){
+    release(&idelock);
+    return;
+  }
+  ideactive = 0;
+
+  if(bmbase){
+    // Stop the bus master and acknowledge the interrupt.
+    st = inb(bmbase + BM_STATUS);
+    outb(bmbase + BM_CMD, 0);
+    outb(bmbase + BM_STATUS, st | BM_ST_ERR | BM_ST_INTR);
+    if(idewait(1) < 0 || (st & BM_ST_ERR))
+      panic("ideintr: dma");
+  } else if(!(b->flags & B_DIRTY) && idewait(1) >= 0){
+    // Read data if needed.
+    insl(0x1f0, b->data, BSIZE/4);
+  }
+
+  // Wake processes waiting for the bufs in the batch.
+  for(; b; b = next){
+    next = b->qnext;
+    b->flags |= B_VALID;
+    b->flags &= ~B_DIRTY;
+    wakeup(b);
+
+    // 추가: readahead 요청은 기다리는 프로세스가 없으므로 여기서 버퍼를 놓아줌
+    if(b->flags & B_ASYNC)
+      bdone(b);
+  }
+
+  // Start disk on next batch in queue.
+  idenext();
+
+  release(&idelock);
+}
+
+//PAGEBREAK!
+// Sync buf with disk.
+// If B_DIRTY is set, write buf to disk, clear B_DIRTY, set B_VALID.
+// Else if B_VALID is not set, read buf from disk, set B_VALID.
+void
+iderw(struct buf *b)
+{
+  iderwv(&b, 1);
+}
+
+// 추가: 여러 버퍼를 한꺼번에 큐에 넣고 모두 끝날 때까지 기다림.
+// 큐에 같이 들어간 연속 블록은 idenext()가 한 번의 DMA로 합침.
+void
+iderwv(struct buf **bs, int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++){
+    if(!holdingsleep(&bs[i]->lock))
+      panic("iderw: buf not locked");
+    if((bs[i]->flags & (B_VALID|B_DIRTY)) == B_VALID)
+      panic("iderw: nothing to do");
+    if(bs[i]->dev != 0 && !havedisk1)
+      panic("iderw: ide disk 1 not present");
+  }
+
+  acquire(&idelock);  //DOC:acquire-lock
+
+  for(i = 0; i < n; i++)
+    ideinsert(bs[i]);
+
+  // Start disk if necessary.
+  idenext();
+
+  // Wait for requests to finish.
+  for(i = 0; i < n; i++){
+    while((bs[i]->flags & (B_VALID|B_DIRTY)) != B_VALID){
+      sleep(bs[i], &idelock);
+    }
+  }
+
+  release(&idelock);
+}
+
+// 추가: readahead용 비동기 읽기.
+// b를 idequeue에 넣고 완료를 기다리지 않고 반환함.
+// 완료되면 ideintr가 bdone()으로 버퍼를 놓아줌.
+void
+iderw_async(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("iderw_async: buf not locked");
+  if((b->flags & (B_VALID|B_DIRTY|B_ASYNC)) != B_ASYNC)
+    panic("iderw_async: not a readahead");
+  if(b->dev != 0 && !havedisk1)
+    panic("iderw_async: ide disk 1 not present");
+
+  acquire(&idelock);
+
+  ideinsert(b);
+
+  // Start disk if necessary.
+  idenext();
+
+  release(&idelock);
+}
@@ -0,0 +1,262 @@
+// Physical memory allocator, intended to allocate
+// memory for user processes, kernel stacks, page table pages,
+// and pipe buffers. Allocates 4096-byte pages.
+//
+// 추가: CPU마다 빈 페이지 목록과 락을 따로 둠. kfree()는 지금 CPU의
+// 목록에 넣고 kalloc()은 지금 CPU의 목록에서 꺼내므로 CPU끼리 락을
+// 다투지 않음. 목록이 비면 다른 CPU 목록에서 KSTEAL개까지 가져옴.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "proc.h"  // 추가: ncpu
+
+#define KSTEAL 64  // pages taken from another CPU at a time
+
+void freerange(void *vstart, void *vend);
+extern char end[]; // first address after kernel loaded from ELF file
+                   // defined by the kernel linker script in kernel.ld
+
+struct run {
+  struct run *next;
+};
+
+struct kfreelist {
+  struct spinlock lock;
+  struct run *freelist;
+};
+
+struct {
+  int use_lock;
+  struct kfreelist cpu[NCPU];
+  // 추가: 물리 페이지마다 그 페이지를 가리키는 곳의 수.
+  // copy-on-write fork로 여러 프로세스가 한 페이지를 같이 씀.
+  // 락 없이 원자적으로 고침.
+  ushort ref[PHYSTOP/PGSIZE];
+  // 추가: 어느 빈 페이지 목록에 들어 있는가. 그 목록의 락으로 보호함.
+  uchar onlist[PHYSTOP/PGSIZE];
+} kmem;
+
+// Initialization happens in two phases.
+// 1. main() calls kinit1() while still using entrypgdir to place just
+// the pages mapped by entrypgdir on free list.
+// 2. main() calls kinit2() with the rest of the physical pages
+// after installing a full page table that maps them on all cores.
+// 추가: 락을 쓰기 전(kinit2가 끝나기 전)에는 모든 페이지가 CPU 0의
+// 목록에 들어가고, 다른 CPU는 처음 할당할 때 거기서 가져감.
+void
+kinit1(void *vstart, void *vend)
+{
+  int i;
+
+  for(i = 0; i < NCPU; i++)
+    initlock(&kmem.cpu[i].lock, "kmem");
+  kmem.use_lock = 0;
+  freerange(vstart, vend);
+}
+
+void
+kinit2(void *vstart, void *vend)
+{
+  freerange(vstart, vend);
+  kmem.use_lock = 1;
+}
+
+void
+freerange(void *vstart, void *vend)
+{
+  char *p;
+  p = (char*)PGROUNDUP((uint)vstart);
+  for(; p + PGSIZE <= (char*)vend; p += PGSIZE)
+    kfree(p);
+}
+
+// 추가: 빈 페이지 목록에 넣고 빼기. Caller must hold l->lock
+// (or be running before kinit2 has finished).
+static void
+kpush(struct kfreelist *l, struct run *r)
+{
+  kmem.onlist[V2P(r)/PGSIZE] = 1;
+  r->next = l->freelist;
+  l->freelist = r;
+}
+
+static struct run*
+kpop(struct kfreelist *l)
+{
+  struct run *r;
+
+  r = l->freelist;
+  if(r){
+    l->freelist = r->next;
+    kmem.onlist[V2P(r)/PGSIZE] = 0;
+  }
+  return r;
+}
+
+//PAGEBREAK: 21
+// Free the page of physical memory pointed at by v,
+// which normally should have been returned by a
+// call to kalloc().  (The exception is when
+// initializing the allocator; see kinit above.)
+void
+kfree(char *v)
+{
+  struct kfreelist *l;
+  ushort *ref;
+
+  if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
+    panic("kfree");
+
+  // 추가: 공용 0 페이지는 참조를 세지 않고 놓아주지도 않음.
+  // 지연 할당 페이지를 읽기만 해도 하나씩 늘어나서 ref가 넘칠 수 있음.
+  if(v == zeropage)
+    return;
+
+  // 추가: 아직 다른 곳에서 쓰고 있으면 참조만 하나 줄임.
+  // freerange()에서 처음 들어오는 페이지는 ref가 0임.
+  ref = &kmem.ref[V2P(v)/PGSIZE];
+  if(*ref != 0 && __sync_sub_and_fetch(ref, 1) != 0)
+    return;
+
+  // Fill with junk to catch dangling refs.
+  memset(v, 1, PGSIZE);
+
+  if(!kmem.use_lock){
+    kpush(&kmem.cpu[0], (struct run*)v);
+    return;
+  }
+  pushcli();  // cpuid() needs interrupts off
+  l = &kmem.cpu[cpuid()];
+  acquire(&l->lock);
+  kpush(l, (struct run*)v);
+  release(&l->lock);
+  popcli();
+}
+
+// 추가: 다른 CPU의 목록에서 KSTEAL개까지 가져와 하나는 돌려주고
+// 나머지는 이 CPU(me)의 목록에 넣음. 두 목록의 락을 한꺼번에 잡지 않음.
+static struct run*
+ksteal(int me)
+{
+  struct kfreelist *l;
+  struct run *r, *got;
+  int i, n;
+
+  for(i = 1; i < ncpu; i++){
+    l = &kmem.cpu[(me + i) % ncpu];
+    got = 0;
+    acquire(&l->lock);
+    for(n = 0; n < KSTEAL && (r = kpop(l)) != 0; n++){
+      r->next = got;
+      got = r;
+    }
+    release(&l->lock);
+    if(got == 0)
+      continue;
+
+    l = &kmem.cpu[me];
+    acquire(&l->lock);
+    for(r = got->next; r; r = got->next){
+      got->next = r->next;
+      kpush(l, r);
+    }
+    release(&l->lock);
+    return got;
+  }
+  return 0;
+}
+
+// Allocate one 4096-byte page of physical memory.
+// Returns a pointer that the kernel can use.
+// Returns 0 if the memory cannot be allocated.
+char*
+kalloc(void)
+{
+  struct kfreelist *l;
+  struct run *r;
+  int me;
+
+  if(!kmem.use_lock){
+    r = kpop(&kmem.cpu[0]);
+  } else {
+    pushcli();  // cpuid() needs interrupts off
+    me = cpuid();
+    l = &kmem.cpu[me];
+    acquire(&l->lock);
+    r = kpop(l);
+    release(&l->lock);
+    if(r == 0)
+      r = ksteal(me);
+    popcli();
+  }
+  if(r)
+    kmem.ref[V2P(r)/PGSIZE] = 1;
+  return (char*)r;
+}
+
+// 추가: kalloc()한 페이지 v를 가리키는 곳이 하나 더 생김.
+// kfree()는 마지막 참조가 사라질 때만 실제로 놓아줌.
+void
+kref(char *v)
+{
+  if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
+    panic("kref");
+  if(v == zeropage)
+    return;
+  if(__sync_fetch_and_add(&kmem.ref[V2P(v)/PGSIZE], 1) == 0)
+    panic("kref: free page");
+}
+
+// 추가: 페이지 v를 가리키는 곳의 수.
+int
+krefcount(char *v)
+{
+  return kmem.ref[V2P(v)/PGSIZE];
+}
+
+// 추가: 4MB에 맞춰 정렬되고 물리적으로 이어진 빈 페이지 NPTENTRIES개를
+// 한꺼번에 할당함 (사용자 슈퍼페이지용). 없으면 0.
+// 각 페이지는 kalloc()한 것과 같아서 ref가 1이고 kfree()로 하나씩 놓아줌.
+// 모든 CPU의 목록을 잠그고 전부 훑으므로 드물게만 불러야 함.
+char*
+kallocsuper(void)
+{
+  struct run **rp;
+  uint pa, i;
+  int c;
+
+  for(c = 0; c < NCPU; c++)
+    acquire(&kmem.cpu[c].lock);
+  for(pa = SUPERPGROUNDUP(V2P(end)); pa + SUPERPGSIZE <= PHYSTOP; pa += SUPERPGSIZE){
+    for(i = 0; i < NPTENTRIES; i++)
+      if(!kmem.onlist[pa/PGSIZE + i])
+        break;
+    if(i == NPTENTRIES)
+      goto found;
+  }
+  for(c = NCPU-1; c >= 0; c--)
+    release(&kmem.cpu[c].lock);
+  return 0;
+
+found:
+  // 이 범위의 페이지를 빈 페이지 목록에서 모두 빼냄
+  for(c = 0; c < NCPU; c++){
+    for(rp = &kmem.cpu[c].freelist; *rp; ){
+      if(V2P(*rp) >= pa && V2P(*rp) < pa + SUPERPGSIZE)
+        *rp = (*rp)->next;
+      else
+        rp = &(*rp)->next;
+    }
+  }
+  for(i = 0; i < NPTENTRIES; i++){
+    kmem.onlist[pa/PGSIZE + i] = 0;
+    kmem.ref[pa/PGSIZE + i] = 1;
+  }
+  for(c = NCPU-1; c >= 0; c--)
+    release(&kmem.cpu[c].lock);
+  return P2V(pa);
+}
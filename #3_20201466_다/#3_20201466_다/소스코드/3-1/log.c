@@ -0,0 +1,327 @@
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+
+// Simple logging that allows concurrent FS system calls.
+//
+// A log transaction contains the updates of multiple FS system
+// calls. The logging system only commits when there are
+// no FS system calls active. Thus there is never
+// any reasoning required about whether a commit might
+// write an uncommitted system call's updates to disk.
+//
+// A system call should call begin_op()/end_op() to mark
+// its start and end. Usually begin_op() just increments
+// the count of in-progress FS system calls and returns.
+// But if it thinks the log is close to running out, it
+// sleeps until the last outstanding end_op() commits.
+//
+// 추가: group commit. end_op()은 로그가 거의 찼을 때만 커밋하고,
+// 그 외에는 끝난 트랜잭션들을 로그에 모아 둠. 모인 트랜잭션은
+// logflush 커널 프로세스가 LOGFLUSHTICKS마다, 또는 fsync()가
+// log_flush()로 한 번에 커밋함. 같은 블록을 여러 트랜잭션이
+// 기록하면 log_write()에서 한 번으로 흡수됨.
+//
+// The log is a physical re-do log containing disk blocks.
+// The on-disk log format:
+//   header block, containing block #s for block A, B, C, ...
+//   block A
+//   block B
+//   block C
+//   ...
+// Log appends are synchronous.
+
+// Contents of the header block, used for both the on-disk header block
+// and to keep track in memory of logged block# before commit.
+struct logheader {
+  int n;
+  int block[LOGSIZE];
+};
+
+struct log {
+  struct spinlock lock;
+  int start;
+  int size;
+  int outstanding; // how many FS sys calls are executing.
+  int committing;  // in commit(), please wait.
+  int syncing;     // log_flush() is waiting to commit; hold off new ops.
+  int dev;
+  struct logheader lh;
+};
+struct log log;
+
+static void recover_from_log(void);
+static void commit();
+static void groupcommit(void);
+static void logflusher(void);
+
+void
+initlog(int dev)
+{
+  if (sizeof(struct logheader) >= BSIZE)
+    panic("initlog: too big logheader");
+
+  struct superblock sb;
+  initlock(&log.lock, "log");
+  readsb(dev, &sb);
+  log.start = sb.logstart;
+  log.size = sb.nlog;
+  log.dev = dev;
+  recover_from_log();
+  kthread("logflush", logflusher);
+}
+
+// Copy committed blocks from log to their home location
+static void
+install_trans(void)
+{
+  int tail, i, n;
+  struct buf *dbufs[LOGBATCH];
+
+  // 추가: LOGBATCH개씩 모아서 한 번에 씀
+  for (tail = 0; tail < log.lh.n; tail += n) {
+    n = log.lh.n - tail;
+    if(n > LOGBATCH)
+      n = LOGBATCH;
+    for (i = 0; i < n; i++) {
+      struct buf *lbuf = bread(log.dev, log.start+tail+i+1); // read log block
+      dbufs[i] = bread(log.dev, log.lh.block[tail+i]); // read dst
+      memmove(dbufs[i]->data, lbuf->data, BSIZE);  // copy block to dst
+      brelse(lbuf);
+    }
+    bwritev(dbufs, n);  // write dst to disk
+    for (i = 0; i < n; i++)
+      brelse(dbufs[i]);
+  }
+}
+
+// Read the log header from disk into the in-memory log header
+static void
+read_head(void)
+{
+  struct buf *buf = bread(log.dev, log.start);
+  struct logheader *lh = (struct logheader *) (buf->data);
+  int i;
+  log.lh.n = lh->n;
+  for (i = 0; i < log.lh.n; i++) {
+    log.lh.block[i] = lh->block[i];
+  }
+  brelse(buf);
+}
+
+// Write in-memory log header to disk.
+// This is the true point at which the
+// current transaction commits.
+static void
+write_head(void)
+{
+  struct buf *buf = bread(log.dev, log.start);
+  struct logheader *hb = (struct logheader *) (buf->data);
+  int i;
+  hb->n = log.lh.n;
+  for (i = 0; i < log.lh.n; i++) {
+    hb->block[i] = log.lh.block[i];
+  }
+  bwrite(buf);
+  brelse(buf);
+}
+
+static void
+recover_from_log(void)
+{
+  read_head();
+  install_trans(); // if committed, copy from log to disk
+  log.lh.n = 0;
+  write_head(); // clear the log
+}
+
+// called at the start of each FS system call.
+void
+begin_op(void)
+{
+  begin_opn(1);
+}
+
+// 추가: MAXOPBLOCKS*nop 블록을 쓸 수 있는 큰 트랜잭션을 시작함.
+// 로그 공간은 FS system call nop개 분량으로 예약됨.
+void
+begin_opn(int nop)
+{
+  if(nop < 1 || nop*MAXOPBLOCKS > LOGSIZE)
+    panic("begin_opn");
+
+  acquire(&log.lock);
+  while(1){
+    if(log.committing || log.syncing){
+      sleep(&log, &log.lock);
+    } else if(log.lh.n + (log.outstanding+nop)*MAXOPBLOCKS > LOGSIZE){
+      if(log.outstanding == 0)
+        // 추가: 끝난 트랜잭션들로 로그가 찼으므로 직접 커밋해서 공간을 만듦
+        groupcommit();
+      else
+        // this op might exhaust log space; wait for commit.
+        sleep(&log, &log.lock);
+    } else {
+      log.outstanding += nop;
+      release(&log.lock);
+      break;
+    }
+  }
+}
+
+// called at the end of each FS system call.
+// commits if this was the last outstanding operation
+// and the log has no room left for another one.
+void
+end_op(void)
+{
+  end_opn(1);
+}
+
+// 추가: begin_opn(nop)으로 시작한 트랜잭션을 끝냄.
+void
+end_opn(int nop)
+{
+  acquire(&log.lock);
+  log.outstanding -= nop;
+  if(log.committing)
+    panic("log.committing");
+  if(log.outstanding == 0 && log.lh.n + MAXOPBLOCKS > LOGSIZE){
+    groupcommit();
+  } else {
+    // begin_op() may be waiting for log space,
+    // and decrementing log.outstanding has decreased
+    // the amount of reserved space.
+    // log_flush() may be waiting for log.outstanding to reach 0.
+    wakeup(&log);
+  }
+  release(&log.lock);
+}
+
+// 추가: 로그에 모인 트랜잭션들을 한 번에 커밋함.
+// Caller must hold log.lock, and no FS system call may be
+// outstanding.
+static void
+groupcommit(void)
+{
+  log.committing = 1;
+  // call commit w/o holding locks, since not allowed
+  // to sleep with locks.
+  release(&log.lock);
+  commit();
+  acquire(&log.lock);
+  log.committing = 0;
+  wakeup(&log);
+}
+
+// 추가: 지금까지 끝난 FS system call들의 변경을 모두 커밋함.
+// 진행 중인 system call이 끝나기를 기다리는 동안 새 트랜잭션은
+// 시작하지 못하게 막음. fsync()와 logflusher가 호출함.
+// Must not be called inside a transaction.
+void
+log_flush(void)
+{
+  acquire(&log.lock);
+  while(log.syncing || log.committing)
+    sleep(&log, &log.lock);
+  if(log.lh.n == 0){
+    release(&log.lock);
+    return;
+  }
+  log.syncing = 1;
+  while(log.outstanding > 0 || log.committing)
+    sleep(&log, &log.lock);
+  if(log.lh.n > 0)
+    groupcommit();
+  log.syncing = 0;
+  wakeup(&log);
+  release(&log.lock);
+}
+
+// 추가: 로그 flusher 커널 프로세스.
+// LOGFLUSHTICKS마다 그동안 모인 트랜잭션들을 커밋함.
+static void
+logflusher(void)
+{
+  uint ticks0;
+
+  for(;;){
+    acquire(&tickslock);
+    ticks0 = ticks;
+    while(ticks - ticks0 < LOGFLUSHTICKS)
+      sleep(&ticks, &tickslock);
+    release(&tickslock);
+    log_flush();
+  }
+}
+
+// Copy modified blocks from cache to log.
+static void
+write_log(void)
+{
+  int tail, i, n;
+  struct buf *to[LOGBATCH];
+
+  for (tail = 0; tail < log.lh.n; tail += n) {
+    n = log.lh.n - tail;
+    if(n > LOGBATCH)
+      n = LOGBATCH;
+    for (i = 0; i < n; i++) {
+      to[i] = bread(log.dev, log.start+tail+i+1); // log block
+      struct buf *from = bread(log.dev, log.lh.block[tail+i]); // cache block
+      memmove(to[i]->data, from->data, BSIZE);
+      brelse(from);
+    }
+    bwritev(to, n);  // write the log
+    for (i = 0; i < n; i++)
+      brelse(to[i]);
+  }
+}
+
+static void
+commit()
+{
+  if (log.lh.n > 0) {
+    write_log();     // Write modified blocks from cache to log
+    write_head();    // Write header to disk -- the real commit
+    install_trans(); // Now install writes to home locations
+    log.lh.n = 0;
+    write_head();    // Erase the transaction from the log
+  }
+}
+
+// Caller has modified b->data and is done with the buffer.
+// Record the block number and pin in the cache with B_DIRTY.
+// commit()/write_log() will do the disk write.
+//
+// log_write() replaces bwrite(); a typical use is:
+//   bp = bread(...)
+//   modify bp->data[]
+//   log_write(bp)
+//   brelse(bp)
+void
+log_write(struct buf *b)
+{
+  int i;
+
+  if (log.lh.n >= LOGSIZE || log.lh.n >= log.size - 1)
+    panic("too big a transaction");
+  if (log.outstanding < 1)
+    panic("log_write outside of trans");
+
+  acquire(&log.lock);
+  for (i = 0; i < log.lh.n; i++) {
+    if (log.lh.block[i] == b->blockno)   // log absorbtion
+      break;
+  }
+  log.lh.block[i] = b->blockno;
+  if (i == log.lh.n)
+    log.lh.n++;
+  b->flags |= B_DIRTY; // prevent eviction
+  release(&log.lock);
+}
+
@@ -0,0 +1,24 @@
+#define NPROC        64  // maximum number of processes
+#define KSTACKSIZE 4096  // size of per-process kernel stack
+#define NCPU          8  // maximum number of CPUs
+#define NOFILE       16  // open files per process
+#define NFILE       100  // open files per system
+#define NINODE       50  // maximum number of active i-nodes
+#define NDEV         10  // maximum major device number
+#define ROOTDEV       1  // device number of file system root disk
+#define TMPDEV        2  // 추가: device number of tmpfs, mounted at /tmp
+#define NTMPINODE    64  // 추가: number of tmpfs inodes
+#define FAMAX        64  // 추가: max pages mapped by one lazy page fault
+#define MAXARG       32  // max exec arguments
+#define MAXOPBLOCKS  10  // max # of blocks any FS op writes
+#define LOGSIZE      (MAXOPBLOCKS*6)  // max data blocks in on-disk log
+#define NBUF         (MAXOPBLOCKS*9)  // size of disk block cache
+#define LOGFLUSHTICKS 100  // ticks between background log commits
+#define LOGBATCH     16  // log blocks written to disk in one batch
+#ifndef FSSIZE  // 추가: Makefile이 kernelmemfs용 mkfs에서 더 작게 줌
+#define FSSIZE       20000  // size of file system in blocks
+#endif
+#define RAMIN         2  // initial readahead window (blocks)
+#define RAMAX         8  // max readahead window (blocks)
+#define URING_PFMAX  (RAMAX*2)  // max blocks one uring_enter prefetches
+#define NURINGWORKER 4  // 추가: uring worker threads
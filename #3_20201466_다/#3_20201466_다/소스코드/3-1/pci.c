@@ -0,0 +1,45 @@
+// 추가: PCI 설정 공간 접근 (configuration mechanism #1).
+// 버스 0만 검색함. QEMU의 기본 장치들은 모두 버스 0에 있음.
+
+#include "types.h"
+#include "defs.h"
+#include "x86.h"
+
+#define PCI_CONFADDR 0xCF8
+#define PCI_CONFDATA 0xCFC
+
+// Device address: device number and function number on bus 0.
+#define PCIADDR(dev, func) (((dev) << 11) | ((func) << 8))
+
+uint
+pciread(uint addr, uint off)
+{
+  outl(PCI_CONFADDR, 0x80000000 | addr | (off & 0xfc));
+  return inl(PCI_CONFDATA);
+}
+
+void
+pciwrite(uint addr, uint off, uint val)
+{
+  outl(PCI_CONFADDR, 0x80000000 | addr | (off & 0xfc));
+  outl(PCI_CONFDATA, val);
+}
+
+// Find the first function with the given vendor and device id.
+// Returns its address for pciread/pciwrite, or -1 if there is none.
+int
+pcifind(ushort vendor, ushort device)
+{
+  uint dev, func, id;
+
+  for(dev = 0; dev < 32; dev++){
+    for(func = 0; func < 8; func++){
+      id = pciread(PCIADDR(dev, func), 0);
+      if((id & 0xffff) == 0xffff)
+        continue;
+      if((id & 0xffff) == vendor && (id >> 16) == device)
+        return PCIADDR(dev, func);
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,299 @@
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "proc.h"
+#include "fs.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "file.h"
+
+// 추가: 링 버퍼를 kalloc()한 페이지 여러 개로 구성함.
+// 한 번의 복사는 페이지 경계를 넘지 않으므로 페이지가 연속일 필요는 없음.
+#define PIPEPAGES 4
+#define PIPESIZE (PIPEPAGES*PGSIZE)
+#define PIPEWAKE (PIPESIZE/2)  // watermark for waking the peer
+
+struct pipe {
+  struct spinlock lock;
+  char *data[PIPEPAGES];
+  uint nread;     // number of bytes read
+  uint nwrite;    // number of bytes written
+  int readopen;   // read fd is still open
+  int writeopen;  // write fd is still open
+  int rwait;      // readers sleeping on nread
+  uint wwant;     // free space a sleeping writer waits for; 0 if none
+  int rbusy;      // splice is reading from data outside the lock
+  int wbusy;      // splice is writing into data outside the lock
+};
+
+// Address of byte off in the ring.
+static char*
+pipeptr(struct pipe *p, uint off)
+{
+  return p->data[(off / PGSIZE) % PIPEPAGES] + off % PGSIZE;
+}
+
+// How many of n bytes starting at off can be copied
+// without crossing a page boundary.
+static uint
+pipechunk(uint off, uint n)
+{
+  if(n > PGSIZE - off % PGSIZE)
+    n = PGSIZE - off % PGSIZE;
+  return n;
+}
+
+// Wake readers, if any are sleeping.  Caller must hold p->lock.
+static void
+pipewakereader(struct pipe *p)
+{
+  if(p->rwait)
+    wakeup(&p->nread);
+}
+
+// Wake a sleeping writer once enough space is free for it.
+// Caller must hold p->lock.
+static void
+pipewakewriter(struct pipe *p)
+{
+  if(p->wwant && PIPESIZE - (p->nwrite - p->nread) >= p->wwant){
+    p->wwant = 0;
+    wakeup(&p->nwrite);
+  }
+}
+
+// Sleep until a reader frees space; want is how much space
+// the writer needs before it is worth waking it.
+static void
+pipewaitwriter(struct pipe *p, uint want)
+{
+  if(want > PIPEWAKE)
+    want = PIPEWAKE;
+  if(p->wwant == 0 || want < p->wwant)
+    p->wwant = want;
+  sleep(&p->nwrite, &p->lock);
+}
+
+// Sleep until a writer adds data.
+static void
+pipewaitreader(struct pipe *p)
+{
+  p->rwait++;
+  sleep(&p->nread, &p->lock);
+  p->rwait--;
+}
+
+int
+pipealloc(struct file **f0, struct file **f1)
+{
+  struct pipe *p;
+  int i;
+
+  p = 0;
+  *f0 = *f1 = 0;
+  if((*f0 = filealloc()) == 0 || (*f1 = filealloc()) == 0)
+    goto bad;
+  if((p = (struct pipe*)kalloc()) == 0)
+    goto bad;
+  memset(p, 0, sizeof(*p));
+  for(i = 0; i < PIPEPAGES; i++)
+    if((p->data[i] = kalloc()) == 0)
+      goto bad;
+  p->readopen = 1;
+  p->writeopen = 1;
+  p->nwrite = 0;
+  p->nread = 0;
+  initlock(&p->lock, "pipe");
+  (*f0)->type = FD_PIPE;
+  (*f0)->readable = 1;
+  (*f0)->writable = 0;
+  (*f0)->pipe = p;
+  (*f1)->type = FD_PIPE;
+  (*f1)->readable = 0;
+  (*f1)->writable = 1;
+  (*f1)->pipe = p;
+  return 0;
+
+//PAGEBREAK: 20
+ bad:
+  if(p){
+    for(i = 0; i < PIPEPAGES && p->data[i]; i++)
+      kfree(p->data[i]);
+    kfree((char*)p);
+  }
+  if(*f0)
+    fileclose(*f0);
+  if(*f1)
+    fileclose(*f1);
+  return -1;
+}
+
+void
+pipeclose(struct pipe *p, int writable)
+{
+  int i;
+
+  acquire(&p->lock);
+  if(writable){
+    p->writeopen = 0;
+    wakeup(&p->nread);
+  } else {
+    p->readopen = 0;
+    wakeup(&p->nwrite);
+  }
+  if(p->readopen == 0 && p->writeopen == 0){
+    release(&p->lock);
+    for(i = 0; i < PIPEPAGES; i++)
+      kfree(p->data[i]);
+    kfree((char*)p);
+  } else
+    release(&p->lock);
+}
+
+//PAGEBREAK: 40
+// 추가: 한 바이트씩이 아니라 페이지 안에서 연속인 만큼 memmove로 복사하고,
+// 읽는 쪽은 버퍼가 꽉 찼거나 절반 이상 찼을 때와 쓰기가 끝났을 때만 깨움.
+int
+pipewrite(struct pipe *p, char *addr, int n)
+{
+  int i, m;
+
+  acquire(&p->lock);
+  for(i = 0; i < n; i += m){
+    while(p->nwrite == p->nread + PIPESIZE || p->wbusy){  //DOC: pipewrite-full
+      if(p->readopen == 0 || myproc()->killed){
+        release(&p->lock);
+        return -1;
+      }
+      pipewakereader(p);
+      pipewaitwriter(p, n - i);  //DOC: pipewrite-sleep
+    }
+    m = pipechunk(p->nwrite, PIPESIZE - (p->nwrite - p->nread));
+    if(m > n - i)
+      m = n - i;
+    memmove(pipeptr(p, p->nwrite), addr + i, m);
+    p->nwrite += m;
+    if(p->nwrite - p->nread >= PIPEWAKE)
+      pipewakereader(p);
+  }
+  pipewakereader(p);  //DOC: pipewrite-wakeup1
+  release(&p->lock);
+  return n;
+}
+
+// 추가: 쓰는 쪽은 PIPEWAKE 이상(또는 남은 쓰기만큼) 비었을 때만 깨움.
+int
+piperead(struct pipe *p, char *addr, int n)
+{
+  int i, m;
+
+  acquire(&p->lock);
+  while((p->nread == p->nwrite && p->writeopen) || p->rbusy){  //DOC: pipe-empty
+    if(myproc()->killed){
+      release(&p->lock);
+      return -1;
+    }
+    pipewaitreader(p); //DOC: piperead-sleep
+  }
+  for(i = 0; i < n && p->nread != p->nwrite; i += m){  //DOC: piperead-copy
+    m = pipechunk(p->nread, p->nwrite - p->nread);
+    if(m > n - i)
+      m = n - i;
+    memmove(addr + i, pipeptr(p, p->nread), m);
+    p->nread += m;
+  }
+  pipewakewriter(p);  //DOC: piperead-wakeup
+  release(&p->lock);
+  return i;
+}
+
+// 추가: splice. 파이프의 링 버퍼 페이지와 파일 사이에서 바로 복사함.
+// 복사하는 동안 lock을 놓아야 하므로(파일 I/O는 sleep함)
+// rbusy/wbusy로 그 구간을 다른 reader/writer로부터 지킴.
+
+// Move up to n bytes from pipe p to file f.  Like piperead,
+// waits for data and returns what was there, 0 at end of file.
+int
+pipespliceout(struct pipe *p, struct file *f, int n)
+{
+  int tot, m;
+
+  acquire(&p->lock);
+  while((p->nread == p->nwrite && p->writeopen) || p->rbusy){
+    if(myproc()->killed){
+      release(&p->lock);
+      return -1;
+    }
+    pipewaitreader(p);
+  }
+  p->rbusy = 1;
+  for(tot = 0; tot < n && p->nread != p->nwrite; tot += m){
+    m = pipechunk(p->nread, p->nwrite - p->nread);
+    if(m > n - tot)
+      m = n - tot;
+    // Only we move nread, and writers stop short of it.
+    release(&p->lock);
+    m = filewrite(f, pipeptr(p, p->nread), m);
+    acquire(&p->lock);
+    if(m < 0){
+      if(tot == 0)
+        tot = -1;
+      break;
+    }
+    p->nread += m;
+    pipewakewriter(p);
+  }
+  p->rbusy = 0;
+  pipewakereader(p);
+  release(&p->lock);
+  return tot;
+}
+
+// Move up to n bytes from file f into pipe p.  Returns the
+// number of bytes moved, less than n at end of file.
+int
+pipesplicein(struct pipe *p, struct file *f, int n)
+{
+  int tot, m, r;
+
+  acquire(&p->lock);
+  for(tot = 0; tot < n; tot += r){
+    while(p->nwrite == p->nread + PIPESIZE || p->wbusy){
+      if(p->readopen == 0 || myproc()->killed){
+        release(&p->lock);
+        // f에서 이미 읽어 옮긴 만큼은 알려 줘야 함
+        return tot > 0 ? tot : -1;
+      }
+      pipewakereader(p);
+      pipewaitwriter(p, n - tot);
+    }
+    p->wbusy = 1;
+    m = pipechunk(p->nwrite, PIPESIZE - (p->nwrite - p->nread));
+    if(m > n - tot)
+      m = n - tot;
+    // Only we move nwrite, and readers stop short of it.
+    release(&p->lock);
+    r = fileread(f, pipeptr(p, p->nwrite), m);
+    acquire(&p->lock);
+    p->wbusy = 0;
+    if(p->wwant){
+      // Writers may be waiting for wbusy to clear.
+      p->wwant = 0;
+      wakeup(&p->nwrite);
+    }
+    if(r <= 0){
+      if(r < 0 && tot == 0)
+        tot = -1;
+      break;
+    }
+    p->nwrite += r;
+    if(p->nwrite - p->nread >= PIPEWAKE)
+      pipewakereader(p);
+    if(r < m)
+      break;
+  }
+  pipewakereader(p);
+  release(&p->lock);
+  return tot;
+}
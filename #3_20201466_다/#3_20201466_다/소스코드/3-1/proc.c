@@ -6,6 +6,7 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "vdso.h"
 
 struct {
   struct spinlock lock;
@@ -93,6 +94,9 @@ found:
   p->dealloc_size = 0;
   p->dealloc_ticks = 0;
   p->dealloc_bool = 0;
+  p->fanext = 0;
+  p->fawin = 0;
+  p->uringk = 0;
 
   release(&ptable.lock);
 
@@ -101,6 +105,15 @@ found:
     p->state = UNUSED;
     return 0;
   }
+  // 추가: vDSO의 프로세스별 페이지
+  if((p->vdso = kalloc()) == 0){
+    kfree(p->kstack);
+    p->kstack = 0;
+    p->state = UNUSED;
+    return 0;
+  }
+  memset(p->vdso, 0, PGSIZE);
+  ((struct vdsoproc*)p->vdso)->pid = p->pid;
   sp = p->kstack + KSTACKSIZE;
 
   // Leave room for trap frame.
@@ -134,6 +147,8 @@ userinit(void)
   if((p->pgdir = setupkvm()) == 0)
     panic("userinit: out of memory?");
   inituvm(p->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
+  if(vdsomap(p->pgdir, p) < 0)
+    panic("userinit: vdsomap");
   p->sz = PGSIZE;
   memset(p->tf, 0, sizeof(*p->tf));
   p->tf->cs = (SEG_UCODE << 3) | DPL_USER;
@@ -158,6 +173,30 @@ userinit(void)
   release(&ptable.lock);
 }
 
+// 추가: 커널 안에서만 도는 프로세스를 만듦 (예: 로그 flusher).
+// forkret이 trapret 대신 fn으로 돌아가도록 스택을 바꿔 둠.
+// fn은 반환하면 안 됨.
+void
+kthread(char *name, void (*fn)(void))
+{
+  struct proc *p;
+
+  if((p = allocproc()) == 0)
+    panic("kthread: no proc");
+  if((p->pgdir = setupkvm()) == 0)
+    panic("kthread: out of memory?");
+  *(uint*)(p->context + 1) = (uint)fn;
+  p->sz = 0;
+  p->parent = initproc;
+  safestrcpy(p->name, name, sizeof(p->name));
+
+  acquire(&ptable.lock);
+
+  p->state = RUNNABLE;
+
+  release(&ptable.lock);
+}
+
 // Grow current process's memory by n bytes.
 // Return 0 on success, -1 on failure.
 int
@@ -171,6 +210,7 @@ growproc(int n)
     if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
   } else if(n < 0){
+    uringdrain(curproc);  // 추가: 링 요청이 쓰는 페이지일 수 있음
     if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
   }
@@ -194,10 +234,19 @@ fork(void)
     return -1;
   }
 
+  // 추가: 링 요청이 쓰는 페이지를 copy-on-write로 바꾸기 전에 끝냄
+  uringdrain(curproc);
+
   // Copy process state from proc.
-  if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
+  if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0 ||
+     vdsomap(np->pgdir, np) < 0){
+    if(np->pgdir)
+      freevm(np->pgdir);
+    np->pgdir = 0;
     kfree(np->kstack);
     np->kstack = 0;
+    kfree(np->vdso);
+    np->vdso = 0;
     np->state = UNUSED;
     return -1;
   }
@@ -214,6 +263,8 @@ fork(void)
   np->cwd = idup(curproc->cwd);
 
   safestrcpy(np->name, curproc->name, sizeof(curproc->name));
+  np->tracemask = curproc->tracemask;  // 추가: 자식도 추적
+  np->uring = curproc->uring;  // 추가: 복사된 링이 같은 주소에 있음
 
   pid = np->pid;
 
@@ -239,6 +290,8 @@ exit(void)
   if(curproc == initproc)
     panic("init exiting");
 
+  uringfree(curproc);  // 추가
+
   // Close all open files.
   for(fd = 0; fd < NOFILE; fd++){
     if(curproc->ofile[fd]){
@@ -294,6 +347,8 @@ wait(void)
         pid = p->pid;
         kfree(p->kstack);
         p->kstack = 0;
+        kfree(p->vdso);
+        p->vdso = 0;
         freevm(p->pgdir);
         p->pid = 0;
         p->parent = 0;
@@ -412,6 +467,7 @@ forkret(void)
     first = 0;
     iinit(ROOTDEV);
     initlog(ROOTDEV);
+    uringinit();  // 추가
   }
 
   // Return to "caller", actually trapret (see allocproc).
@@ -553,6 +609,8 @@ memstat(void)
     vp += 1;
 
   // 물리 페이지 수 계산
+  // 추가: 슈퍼페이지는 walkpgdir()가 PDE를 돌려주므로 4KB마다 하나씩 세어
+  // 1024개가 됨
   for(uint i = 0; i < sz; i += PGSIZE){
     pte_t *pte = walkpgdir(pgdir, (void*)i, 0);
     if(pte && (*pte & PTE_P)){
@@ -573,7 +631,7 @@ memstat(void)
     if(pte && (*pte & PTE_P) && (*pte & PTE_U)){
       if(!first)
         cprintf(" - ");
-      cprintf("0x%x", PTE_ADDR(*pte));
+      cprintf("0x%x", ptepa(pte, (void*)i));
       first = 0;
     }
   }
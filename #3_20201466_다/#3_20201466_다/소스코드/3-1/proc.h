@@ -54,6 +54,12 @@ struct proc {
   int dealloc_size;            // 해제할 메모리 크기
   uint dealloc_ticks;          // 해제할 tick 타임(지연 tick을 더한 값)
   int dealloc_bool;            // 메모리 해제 요청 여부
+  unsigned long long tracemask;  // 추가: 기록할 시스템 콜 (1 << SYS_x)
+  uint uring;                  // 추가: I/O 링의 사용자 주소, 없으면 0
+  struct uringctx *uringk;     // 추가: 링의 커널 쪽 상태 (uring.c)
+  char *vdso;                  // 추가: vDSO의 프로세스별 페이지 (struct vdsoproc)
+  uint fanext;                 // 추가: 지난 페이지 폴트 창 바로 다음 주소
+  int fawin;                   // 추가: 지난 페이지 폴트 창 크기 (페이지)
 };
 
 // Process memory is laid out contiguously, low addresses first:
@@ -0,0 +1,32 @@
+// 시스템 콜 추적 (strace 비슷한 것).
+// 사용법: strace mask 명령 [인자...]
+// mask의 비트 n이 켜져 있으면 시스템 콜 n을 기록함 (syscall.h의 번호 1~31).
+// -1이면 32번 이후까지 전부. 명령이 끝나면 sysstat()으로 부팅 후 통계와 기록을 찍음.
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+int main(int argc, char *argv[]) {
+    int pid, mask;
+
+    if (argc < 3) {
+        printf(2, "usage: strace mask command [args...]\n");
+        exit();
+    }
+    mask = argv[1][0] == '-' ? -atoi(argv[1] + 1) : atoi(argv[1]);
+
+    pid = fork();
+    if (pid < 0) {
+        printf(2, "strace: fork failed\n");
+        exit();
+    }
+    if (pid == 0) {
+        trace(mask, mask == -1 ? -1 : 0);
+        exec(argv[2], argv + 2);
+        printf(2, "strace: exec %s failed\n", argv[2]);
+        exit();
+    }
+    wait();
+    sysstat();
+    exit();
+}
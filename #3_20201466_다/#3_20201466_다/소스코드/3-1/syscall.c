@@ -6,12 +6,14 @@
 #include "proc.h"
 #include "x86.h"
 #include "syscall.h"
+#include "spinlock.h"
 
 // User code makes a system call with INT T_SYSCALL.
 // System call number in %eax.
 // Arguments on the stack, from the user call to the C
 // library system call function. The saved user %esp points
 // to a saved program counter, and then the first argument.
+// 추가: usys.S는 sysenter로 들어오며 인자를 레지스터로 넘김 (argint 참고).
 
 // Fetch the int at addr from the current process.
 int
@@ -46,10 +48,24 @@ fetchstr(uint addr, char **pp)
 }
 
 // Fetch the nth 32-bit system call argument.
+// 추가: usys.S 스텁(sysenter)은 인자를 레지스터에 넣어 오므로
+// 사용자 스택을 읽거나 p->sz와 비교할 필요 없이 trapframe에서 바로 꺼냄.
+// int $T_SYSCALL로 온 호출은 예전처럼 스택에서 읽음.
 int
 argint(int n, int *ip)
 {
-  return fetchint((myproc()->tf->esp) + 4 + 4*n, ip);
+  struct trapframe *tf = myproc()->tf;
+
+  if(tf->err == SYSARG_REG){
+    switch(n){
+    case 0: *ip = tf->ebx; return 0;
+    case 1: *ip = tf->esi; return 0;
+    case 2: *ip = tf->edi; return 0;
+    case 3: *ip = tf->ebp; return 0;
+    }
+    return -1;
+  }
+  return fetchint(tf->esp + 4 + 4*n, ip);
 }
 
 // Fetch the nth word-sized system call argument as a pointer
@@ -69,6 +85,17 @@ argptr(int n, char **pp, int size)
   return 0;
 }
 
+// 추가: 커널이 쓸 버퍼를 받는 argptr. fork 후 같이 쓰는 페이지를
+// 미리 복사해 두어서, 커널 모드에서 쓰다가 copy-on-write 폴트가 나고
+// 메모리가 모자라 panic하는 일이 없게 함. 메모리가 모자라면 -1.
+int
+argptrw(int n, char **pp, int size)
+{
+  if(argptr(n, pp, size) < 0)
+    return -1;
+  return uvmwritable(myproc()->pgdir, (uint)*pp, size);
+}
+
 // Fetch the nth word-sized system call argument as a string pointer.
 // Check that the pointer is valid and the string is nul-terminated.
 // (There is no shared writable memory, so the string can't change
@@ -105,6 +132,18 @@ extern int sys_write(void);
 extern int sys_uptime(void);
 extern int sys_ssusbrk(void);
 extern int sys_memstat(void);
+extern int sys_fsync(void);
+extern int sys_splice(void);
+extern int sys_copy_file_range(void);
+extern int sys_fallocate(void);
+extern int sys_ftruncate(void);
+extern int sys_lseek(void);
+extern int sys_pread(void);
+extern int sys_pwrite(void);
+extern int sys_trace(void);
+extern int sys_sysstat(void);
+extern int sys_uring_setup(void);
+extern int sys_uring_enter(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -130,17 +169,212 @@ static int (*syscalls[])(void) = {
 [SYS_close]   sys_close,
 [SYS_ssusbrk] sys_ssusbrk,
 [SYS_memstat] sys_memstat,
+[SYS_fsync]   sys_fsync,
+[SYS_splice]  sys_splice,
+[SYS_copy_file_range] sys_copy_file_range,
+[SYS_fallocate] sys_fallocate,
+[SYS_ftruncate] sys_ftruncate,
+[SYS_lseek]   sys_lseek,
+[SYS_pread]   sys_pread,
+[SYS_pwrite]  sys_pwrite,
+[SYS_trace]   sys_trace,
+[SYS_sysstat] sys_sysstat,
+[SYS_uring_setup] sys_uring_setup,
+[SYS_uring_enter] sys_uring_enter,
+};
+
+// 추가: 이름과 인자 수. 통계와 추적 기록을 찍을 때 씀.
+static struct {
+  char *name;
+  int nargs;
+} syscallinfo[] = {
+[SYS_fork]    { "fork", 0 },
+[SYS_exit]    { "exit", 0 },
+[SYS_wait]    { "wait", 0 },
+[SYS_pipe]    { "pipe", 1 },
+[SYS_read]    { "read", 3 },
+[SYS_kill]    { "kill", 1 },
+[SYS_exec]    { "exec", 2 },
+[SYS_fstat]   { "fstat", 2 },
+[SYS_chdir]   { "chdir", 1 },
+[SYS_dup]     { "dup", 1 },
+[SYS_getpid]  { "getpid", 0 },
+[SYS_sbrk]    { "sbrk", 1 },
+[SYS_sleep]   { "sleep", 1 },
+[SYS_uptime]  { "uptime", 0 },
+[SYS_open]    { "open", 2 },
+[SYS_write]   { "write", 3 },
+[SYS_mknod]   { "mknod", 3 },
+[SYS_unlink]  { "unlink", 1 },
+[SYS_link]    { "link", 2 },
+[SYS_mkdir]   { "mkdir", 1 },
+[SYS_close]   { "close", 1 },
+[SYS_ssusbrk] { "ssusbrk", 2 },
+[SYS_memstat] { "memstat", 0 },
+[SYS_fsync]   { "fsync", 1 },
+[SYS_splice]  { "splice", 3 },
+[SYS_copy_file_range] { "copy_file_range", 3 },
+[SYS_fallocate] { "fallocate", 3 },
+[SYS_ftruncate] { "ftruncate", 2 },
+[SYS_lseek]   { "lseek", 3 },
+[SYS_pread]   { "pread", 4 },
+[SYS_pwrite]  { "pwrite", 4 },
+[SYS_trace]   { "trace", 2 },
+[SYS_sysstat] { "sysstat", 0 },
+[SYS_uring_setup] { "uring_setup", 0 },
+[SYS_uring_enter] { "uring_enter", 2 },
+};
+
+#define NSYSCALL NELEM(syscalls)
+
+// 추가: 시스템 콜 번호가 tracemask의 비트 수를 넘으면 컴파일 오류.
+typedef char tracemask_fits[NSYSCALL <= 8*sizeof(((struct proc*)0)->tracemask) ? 1 : -1];
+
+// 추가: 시스템 콜별 통계. 락 없이 쓰도록 CPU마다 따로 모으고
+// syscallstat()이 합쳐서 보여 줌. 사이클은 rdtsc로 잰 것이라
+// 잠들어 있던 시간도 들어감.
+struct scstat {
+  uint count;
+  uint errors;
+  unsigned long long total;  // cycles
+  unsigned long long max;
+};
+
+static struct scstat scstat[NCPU][NSYSCALL];
+
+// 추가: 추적 기록. 꽉 차면 가장 오래된 것을 덮어씀.
+#define NTRACE 128
+
+struct tracerec {
+  int pid;
+  int num;
+  int args[4];
+  int ret;
 };
 
+static struct {
+  struct spinlock lock;
+  struct tracerec rec[NTRACE];
+  uint r;      // next record to print
+  uint w;      // next record to fill
+} tracelog;
+
+void
+syscallinit(void)
+{
+  initlock(&tracelog.lock, "tracelog");
+}
+
+static void
+scaccount(int num, int ret, unsigned long long cycles)
+{
+  struct scstat *s;
+
+  pushcli();
+  s = &scstat[cpuid()][num];
+  s->count++;
+  if(ret < 0)
+    s->errors++;
+  s->total += cycles;
+  if(cycles > s->max)
+    s->max = cycles;
+  popcli();
+}
+
+static void
+tracerecord(struct tracerec *t)
+{
+  acquire(&tracelog.lock);
+  if(tracelog.w - tracelog.r == NTRACE)
+    tracelog.r++;
+  tracelog.rec[tracelog.w++ % NTRACE] = *t;
+  release(&tracelog.lock);
+}
+
+// 64비트 나눗셈은 libgcc가 필요하므로 32비트에 들어갈 만큼 줄여서 나눔.
+static uint
+cycdiv(unsigned long long n, uint d)
+{
+  int s;
+
+  for(s = 0; (n >> s) > 0xffffffffULL; s++)
+    ;
+  return ((uint)(n >> s) / d) << s;
+}
+
+static uint
+cyc32(unsigned long long n)
+{
+  return n > 0xffffffffULL ? 0xffffffff : (uint)n;
+}
+
+// 추가: 부팅 후 시스템 콜 통계를 찍고, 쌓인 추적 기록을 비우면서 찍음.
+void
+syscallstat(void)
+{
+  struct scstat sum;
+  struct tracerec t;
+  int c, num, i;
+
+  cprintf("syscall count errors avg-cycles max-cycles total-Kcycles\n");
+  for(num = 1; num < NSYSCALL; num++){
+    memset(&sum, 0, sizeof(sum));
+    for(c = 0; c < ncpu; c++){
+      sum.count += scstat[c][num].count;
+      sum.errors += scstat[c][num].errors;
+      sum.total += scstat[c][num].total;
+      if(scstat[c][num].max > sum.max)
+        sum.max = scstat[c][num].max;
+    }
+    if(sum.count == 0)
+      continue;
+    cprintf("%s %d %d %d %d %d\n", syscallinfo[num].name, sum.count,
+            sum.errors, cycdiv(sum.total, sum.count), cyc32(sum.max),
+            cyc32(sum.total >> 10));
+  }
+
+  for(;;){
+    acquire(&tracelog.lock);
+    if(tracelog.r == tracelog.w){
+      release(&tracelog.lock);
+      break;
+    }
+    t = tracelog.rec[tracelog.r++ % NTRACE];
+    release(&tracelog.lock);
+
+    cprintf("pid %d: %s(", t.pid, syscallinfo[t.num].name);
+    for(i = 0; i < syscallinfo[t.num].nargs; i++)
+      cprintf(i ? ", 0x%x" : "0x%x", t.args[i]);
+    cprintf(") = %d\n", t.ret);
+  }
+}
+
 void
 syscall(void)
 {
-  int num;
+  int num, i;
+  unsigned long long t0;
+  struct tracerec t;
   struct proc *curproc = myproc();
 
   num = curproc->tf->eax;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
+    // 추가: 추적 중이면 인자는 부르기 전에 읽어 둠 (exec가 바꾸므로)
+    if(curproc->tracemask & (1ULL << num)){
+      t.pid = curproc->pid;
+      t.num = num;
+      for(i = 0; i < 4; i++)
+        if(i >= syscallinfo[num].nargs || argint(i, &t.args[i]) < 0)
+          t.args[i] = 0;
+    } else
+      t.num = 0;
+    t0 = rdtsc();
     curproc->tf->eax = syscalls[num]();
+    scaccount(num, curproc->tf->eax, rdtsc() - t0);
+    if(t.num){
+      t.ret = curproc->tf->eax;
+      tracerecord(&t);
+    }
   } else {
     cprintf("%d %s: unknown sys call %d\n",
             curproc->pid, curproc->name, num);
@@ -21,4 +21,20 @@
 #define SYS_mkdir  20
 #define SYS_close  21
 #define SYS_ssusbrk 22
-#define SYS_memstat 23
\ No newline at end of file
+#define SYS_memstat 23
+#define SYS_fsync  24
+#define SYS_splice 25
+#define SYS_copy_file_range 26
+#define SYS_fallocate 27
+#define SYS_ftruncate 28
+#define SYS_lseek  29
+#define SYS_pread  30
+#define SYS_pwrite 31
+#define SYS_trace  32
+#define SYS_sysstat 33
+#define SYS_uring_setup 34
+#define SYS_uring_enter 35
+
+// 추가: trapframe의 err에 이 값이 있으면 인자가 스택이 아니라
+// %ebx, %esi, %edi, %ebp에 있음 (usys.S의 sysenter 스텁).
+#define SYSARG_REG 1
\ No newline at end of file
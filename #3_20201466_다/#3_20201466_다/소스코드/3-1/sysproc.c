@@ -7,6 +7,7 @@
 #include "mmu.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "vdso.h"
 
 // ptable extern 선언
 extern struct {
@@ -113,7 +114,7 @@ int sys_ssusbrk(void) {
             return -1;
 
         uint after_sz = p->sz + size;
-        if(after_sz >= KERNBASE)
+        if(after_sz > VDSOBASE)
             return -1;
 
         // 가상 메모리 크기만 증가
@@ -127,6 +128,10 @@ int sys_ssusbrk(void) {
         if(dealloc_size % PGSIZE != 0 || delay_ticks <= 0)
             return -1;
 
+        // 추가: 해제는 타이머가 하므로 링 요청이 쓰는 페이지가 없게 미리 끝냄.
+        // 해제 전까지 uring_enter는 새 요청을 받지 않음.
+        uringdrain(p);
+
         // 현재 ticks 값을 가져옴
         acquire(&tickslock);
         uint current_ticks = ticks;
@@ -160,4 +165,24 @@ int sys_ssusbrk(void) {
 int sys_memstat(void) {
     memstat();
     return 0;
+}
+
+// 추가: 이 프로세스(와 이후 fork한 자식)가 기록할 시스템 콜을 정함.
+// 시스템 콜이 32개를 넘으므로 mask를 아래 32비트(lo)와 위 32비트(hi)로 받음.
+int
+sys_trace(void)
+{
+  int lo, hi;
+
+  if(argint(0, &lo) < 0 || argint(1, &hi) < 0)
+    return -1;
+  myproc()->tracemask = (unsigned long long)(uint)hi << 32 | (uint)lo;
+  return 0;
+}
+
+int
+sys_sysstat(void)
+{
+  syscallstat();
+  return 0;
 }
\ No newline at end of file
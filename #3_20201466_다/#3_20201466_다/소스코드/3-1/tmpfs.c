@@ -0,0 +1,216 @@
+// 추가: tmpfs. /tmp에 붙는 메모리 파일 시스템.
+//
+// inode는 다른 파일처럼 icache의 struct inode로 다루고 장치 번호만
+// TMPDEV임. 디스크 inode 대신 tmpfs.inode[]가 있고, 데이터는 kalloc()한
+// 페이지에 있음. fs.c는 ip->dev가 TMPDEV이면 디스크(bread/log_write)
+// 대신 여기 함수들을 부르므로 로그나 디스크를 전혀 건드리지 않음.
+// 쓴 적 없는 페이지는 0으로 읽힘.
+//
+// tmpfs.lock은 inode 할당만 보호함. 나머지 필드는 그 inode의
+// ip->lock을 가진 쪽만 다룸.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "stat.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+#define TMPMAXPAGE 256  // max pages per file
+#define TMPMAXFILE (TMPMAXPAGE*PGSIZE)
+
+// The tmpfs counterpart of struct dinode.
+struct tinode {
+  short type;           // 0 if free
+  short major;
+  short minor;
+  short nlink;
+  uint size;
+  char *page[TMPMAXPAGE];
+};
+
+struct {
+  struct spinlock lock;
+  struct tinode inode[NTMPINODE];
+} tmpfs;
+
+static int tmpwrite(struct tinode*, char*, uint, uint);
+
+// Make the root directory, with "." and ".." both pointing at it.
+// namex() takes ".." in the tmpfs root back to the disk root.
+void
+tmpinit(void)
+{
+  struct tinode *t;
+  struct dirent de;
+
+  initlock(&tmpfs.lock, "tmpfs");
+  t = &tmpfs.inode[ROOTINO];
+  t->type = T_DIR;
+  t->nlink = 1;
+  memset(&de, 0, sizeof(de));
+  de.inum = ROOTINO;
+  strncpy(de.name, ".", DIRSIZ);
+  if(tmpwrite(t, (char*)&de, 0, sizeof(de)) < 0)
+    panic("tmpinit");
+  strncpy(de.name, "..", DIRSIZ);
+  if(tmpwrite(t, (char*)&de, sizeof(de), sizeof(de)) < 0)
+    panic("tmpinit");
+  t->size = 2*sizeof(de);
+}
+
+// Allocate a tmpfs inode of type type and return its number.
+uint
+tmpialloc(short type)
+{
+  int inum;
+  struct tinode *t;
+
+  acquire(&tmpfs.lock);
+  for(inum = 1; inum < NTMPINODE; inum++){
+    t = &tmpfs.inode[inum];
+    if(t->type == 0){  // a free inode
+      memset(t, 0, sizeof(*t));
+      t->type = type;
+      release(&tmpfs.lock);
+      return inum;
+    }
+  }
+  panic("ialloc: no tmpfs inodes");
+}
+
+// Fill in ip from its tmpfs inode.  Caller must hold ip->lock.
+void
+tmpiload(struct inode *ip)
+{
+  struct tinode *t;
+
+  t = &tmpfs.inode[ip->inum];
+  ip->type = t->type;
+  ip->major = t->major;
+  ip->minor = t->minor;
+  ip->nlink = t->nlink;
+  ip->size = t->size;
+}
+
+// Copy ip back to its tmpfs inode.  Caller must hold ip->lock.
+void
+tmpiupdate(struct inode *ip)
+{
+  struct tinode *t;
+
+  t = &tmpfs.inode[ip->inum];
+  t->major = ip->major;
+  t->minor = ip->minor;
+  t->nlink = ip->nlink;
+  t->size = ip->size;
+  // A zero type frees the inode; let tmpialloc see it last.
+  if(ip->type == 0){
+    acquire(&tmpfs.lock);
+    t->type = 0;
+    release(&tmpfs.lock);
+  } else
+    t->type = ip->type;
+}
+
+// Free the pages past size bytes and clear the rest of the
+// last page, so growing the file again reads zeros.
+// Caller must hold ip->lock.
+void
+tmpitrunc(struct inode *ip, uint size)
+{
+  struct tinode *t;
+  uint i;
+
+  t = &tmpfs.inode[ip->inum];
+  for(i = (size + PGSIZE - 1) / PGSIZE; i < TMPMAXPAGE; i++){
+    if(t->page[i]){
+      kfree(t->page[i]);
+      t->page[i] = 0;
+    }
+  }
+  if(size % PGSIZE && t->page[size / PGSIZE])
+    memset(t->page[size / PGSIZE] + size % PGSIZE, 0, PGSIZE - size % PGSIZE);
+}
+
+// Read data from a tmpfs inode, like readi().
+int
+tmpreadi(struct inode *ip, char *dst, uint off, uint n)
+{
+  struct tinode *t;
+  uint tot, m;
+  char *p;
+
+  if(off > ip->size || off + n < off)
+    return -1;
+  if(off + n > ip->size)
+    n = ip->size - off;
+
+  t = &tmpfs.inode[ip->inum];
+  for(tot=0; tot<n; tot+=m, off+=m, dst+=m){
+    m = min(n - tot, PGSIZE - off%PGSIZE);
+    if((p = t->page[off/PGSIZE]) != 0)
+      memmove(dst, p + off%PGSIZE, m);
+    else
+      memset(dst, 0, m);
+  }
+  return n;
+}
+
+// Copy n bytes into t's pages at off, allocating pages as needed.
+static int
+tmpwrite(struct tinode *t, char *src, uint off, uint n)
+{
+  uint tot, m;
+  char *p;
+
+  for(tot=0; tot<n; tot+=m, off+=m, src+=m){
+    m = min(n - tot, PGSIZE - off%PGSIZE);
+    if((p = t->page[off/PGSIZE]) == 0){
+      if((p = kalloc()) == 0)
+        return -1;
+      memset(p, 0, PGSIZE);
+      t->page[off/PGSIZE] = p;
+    }
+    memmove(p + off%PGSIZE, src, m);
+  }
+  return n;
+}
+
+// Write data to a tmpfs inode, like writei().
+int
+tmpwritei(struct inode *ip, char *src, uint off, uint n)
+{
+  if(off > ip->size || off + n < off)
+    return -1;
+  if(off + n > TMPMAXFILE)
+    return -1;
+
+  if(tmpwrite(&tmpfs.inode[ip->inum], src, off, n) < 0)
+    return -1;
+
+  if(n > 0 && off + n > ip->size){
+    ip->size = off + n;
+    tmpiupdate(ip);
+  }
+  return n;
+}
+
+// Grow a tmpfs file to end bytes.  The new pages are
+// allocated when written; until then they read as zeros.
+int
+tmpigrow(struct inode *ip, uint end)
+{
+  if(end > TMPMAXFILE)
+    return -1;
+  if(end > ip->size){
+    ip->size = end;
+    tmpiupdate(ip);
+  }
+  return ip->size;
+}
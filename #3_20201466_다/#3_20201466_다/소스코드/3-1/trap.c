@@ -8,12 +8,19 @@
 #include "traps.h"
 #include "spinlock.h"
 #include "date.h"      // date.h 헤더 파일 포함
+#include "syscall.h"   // 추가: SYSARG_REG
+#include "vdso.h"
 
 // Interrupt descriptor table (shared by all CPUs).
 struct gatedesc idt[256];
 extern uint vectors[];  // in vectors.S: array of 256 entry pointers
 struct spinlock tickslock;
 uint ticks;
+int havesysenter;       // 추가: does the CPU have SYSENTER/SYSEXIT?
+// 추가: vDSO의 공유 페이지 (struct vdsodata). 한 페이지를 통째로 차지해야
+// 사용자에게 다른 커널 데이터가 보이지 않음.
+char vdsopage[PGSIZE] __attribute__((aligned(PGSIZE)));
+extern char sysenter_entry[];  // in trapasm.S
 // ptable extern 선언
 extern struct {
   struct spinlock lock;
@@ -29,6 +36,9 @@ tvinit(void)
     SETGATE(idt[i], 0, SEG_KCODE<<3, vectors[i], 0);
   SETGATE(idt[T_SYSCALL], 1, SEG_KCODE<<3, vectors[T_SYSCALL], DPL_USER);
 
+  // 추가: CPUID.1:EDX의 SEP 비트
+  havesysenter = (cpuidedx(1) >> 11) & 1;
+
   initlock(&tickslock, "time");
 }
 
@@ -38,6 +48,78 @@ idtinit(void)
   lidt(idt, sizeof(idt));
 }
 
+// 추가: 이 CPU의 SYSENTER MSR을 설정함.
+// 커널 스택(%esp)은 프로세스마다 다르므로 switchuvm()이 넣음.
+// sysexit은 %cs를 MSR 값+16, %ss를 +24로 잡으므로
+// SEG_KCODE, SEG_KDATA, SEG_UCODE, SEG_UDATA 순서에 기대고 있음.
+void
+sysenterinit(void)
+{
+  if(!havesysenter)
+    return;
+  wrmsr(MSR_SYSENTER_CS, SEG_KCODE<<3, 0);
+  wrmsr(MSR_SYSENTER_ESP, 0, 0);
+  wrmsr(MSR_SYSENTER_EIP, (uint)sysenter_entry, 0);
+}
+
+// 추가: CPU 0의 타이머 인터럽트마다 vDSO 페이지를 고침.
+// 읽는 쪽은 seq가 짝수이고 읽기 전후로 같을 때만 값을 믿음.
+// 두 tick 사이의 TSC 차이로 tscperus를 맞춰 감.
+static void
+vdsotick(void)
+{
+  struct vdsodata *v = (struct vdsodata*)vdsopage;
+  uint tsc, per;
+
+  tsc = (uint)rdtsc();
+  v->seq++;
+  __sync_synchronize();
+  if(v->ticks + 1 == ticks){
+    per = (tsc - v->tsc) / VDSO_USPERTICK;
+    v->tscperus = v->tscperus ? (3*v->tscperus + per) / 4 : per;
+  }
+  v->ticks = ticks;
+  v->tsc = tsc;
+  __sync_synchronize();
+  v->seq++;
+}
+
+// 추가: 지연 할당 페이지 va를 붙임.
+// 쓰기면 0으로 채운 새 페이지를, 읽기면 공용 0 페이지를 읽기 전용으로
+// 붙임. 후자는 나중에 쓸 때 cowcopy()가 이 프로세스만의 페이지를 만듦.
+static int
+lazymap(pde_t *pgdir, uint va, int write)
+{
+  char *mem;
+
+  if(!write){
+    return mappages(pgdir, (char*)va, PGSIZE, V2P(zeropage), PTE_U|PTE_COW);
+  }
+
+  // 물리 메모리 페이지 할당
+  if((mem = kalloc()) == 0)
+    return -1;
+  memset(mem, 0, PGSIZE);
+
+  // 페이지 테이블에 매핑
+  if(mappages(pgdir, (char*)va, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
+    kfree(mem);
+    return -1;
+  }
+  return 0;
+}
+
+// 추가: 사용자 eip에 있는 명령이 sysenter(0f 34)인가?
+static int
+issysenter(uint eip)
+{
+  struct proc *curproc = myproc();
+
+  if(eip >= curproc->sz || eip+2 > curproc->sz)
+    return 0;
+  return *(ushort*)eip == 0x340f;
+}
+
 //PAGEBREAK: 41
 void
 trap(struct trapframe *tf)
@@ -57,6 +139,7 @@ trap(struct trapframe *tf)
     if(cpuid() == 0){
       acquire(&tickslock);
       ticks++;
+      vdsotick();  // 추가
       wakeup(&ticks);
       release(&tickslock);
     }
@@ -112,27 +195,79 @@ trap(struct trapframe *tf)
     uint addr = fault_addr - rest; // 페이지 폴트가 발생한 가상주소의 시작 주소
     struct proc *q = myproc();
 
-    // 물리 메모리 페이지 할당
-    char *mem = kalloc();
-    if(mem == 0){
-      cprintf("allocuvm out of memory\n");
+    // 추가: fork 후 같이 쓰는 페이지에 처음 쓰는 경우. 커널이 쓰는
+    // 사용자 버퍼는 argptrw()/uvmwritable()이 미리 복사해 두므로 여기서
+    // 메모리가 모자라 커널 모드 panic으로 가지는 않음. err의 비트 0은 보호 위반, 비트 1은 쓰기로
+    // PTE_P, PTE_W와 값이 같음.
+    if(q && (tf->err & (PTE_P|PTE_W)) == (PTE_P|PTE_W) &&
+       cowcopy(q->pgdir, addr) == 0)
+      break;
+
+    // 추가: 보호 위반(읽기 전용인 vDSO 페이지에 쓰기 등)이나
+    // 프로세스 메모리 밖은 지연 할당할 페이지가 아님
+    if(q == 0 || (tf->err & PTE_P) || fault_addr >= q->sz){
+      if(q == 0 || (tf->cs&3) == 0){
+        cprintf("page fault from cpu %d eip %x (cr2=0x%x)\n",
+                cpuid(), tf->eip, fault_addr);
+        panic("trap");
+      }
+      cprintf("pid %d %s: page fault err %d eip 0x%x addr 0x%x--kill proc\n",
+              q->pid, q->name, tf->err, tf->eip, fault_addr);
       q->killed = 1;
       break;
     }
-    memset(mem, 0, PGSIZE);
 
-    // 페이지 테이블에 매핑
-    if(mappages(q->pgdir, (char*)addr, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
-      cprintf("allocuvm out of memory (2)\n");
-      kfree(mem);
-      p->killed = 1;
+    // 추가: fault-around. 직전 폴트에서 붙인 창 바로 뒤에서 또 폴트가
+    // 나면 순차 접근으로 보고 창을 두 배로(FAMAX까지) 키워서 이웃
+    // 페이지까지 한 번에 붙임. 아니면 이 페이지 하나만.
+    // 추가: 4MB 영역 전체가 처음 쓰이면 슈퍼페이지 하나로 붙임
+    if((tf->err & PTE_W) && superalloc(q->pgdir, addr, q->sz) == 0)
+      break;
+
+    if(addr == q->fanext && q->fawin > 0)
+      q->fawin = q->fawin*2 > FAMAX ? FAMAX : q->fawin*2;
+    else
+      q->fawin = 1;
+
+    if(lazymap(q->pgdir, addr, tf->err & PTE_W) < 0){
+      cprintf("allocuvm out of memory\n");
+      q->killed = 1;
       break;
     }
+    uint va = addr + PGSIZE;
+    for(int n = 1; n < q->fawin && va < q->sz; n++, va += PGSIZE){
+      if(q->pgdir[PDX(va)] & PTE_PS)
+        break;  // 슈퍼페이지를 쪼개지 않도록
+      pte_t *pte = walkpgdir(q->pgdir, (char*)va, 0);
+      if(pte && (*pte & PTE_P))
+        break;  // 이미 있는 페이지에서 멈춤
+      if(lazymap(q->pgdir, va, tf->err & PTE_W) < 0)
+        break;  // 이웃은 못 붙여도 괜찮음
+    }
+    q->fanext = va;
     break;
 
+  case T_ILLOP:
+    // 추가: SYSENTER가 없는 CPU에서는 usys.S의 sysenter가 #UD로 옴.
+    // sysexit이 했을 일을 trapframe에 해 두고 int $T_SYSCALL처럼 처리함.
+    if((tf->cs&3) == DPL_USER && !havesysenter && issysenter(tf->eip)){
+      tf->eip = tf->edx;
+      tf->esp = tf->ecx;
+      tf->trapno = T_SYSCALL;
+      tf->err = SYSARG_REG;
+      trap(tf);
+      return;
+    }
+    // fall through
 
   //PAGEBREAK: 13
   default:
+    // 추가: virtio 디스크의 IRQ 번호는 PCI 설정에서 정해지므로 여기서 확인함
+    if(havevirtio && tf->trapno == T_IRQ0 + virtioirq){
+      virtiointr();
+      lapiceoi();
+      break;
+    }
     if(myproc() == 0 || (tf->cs&3) == 0){
       // In kernel, it must be our mistake.
       cprintf("unexpected trap %d from cpu %d eip %x (cr2=0x%x)\n",
@@ -0,0 +1,152 @@
+// Intel 8250 serial port (UART).
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "traps.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+#include "mmu.h"
+#include "proc.h"
+#include "x86.h"
+
+#define COM1    0x3f8
+
+// 추가: line status / interrupt enable bits
+#define LSR_RXRDY  0x01   // a received byte is waiting
+#define LSR_THRE   0x20   // transmit holding register (FIFO) empty
+#define IER_RX     0x01   // interrupt on receive
+#define IER_TX     0x02   // interrupt on transmit holding register empty
+#define UARTFIFO   16     // bytes the 16550 transmit FIFO holds
+
+static int uart;    // is there a uart?
+
+// 추가: 송신 링 버퍼. uartputc()는 여기에 넣기만 하고 돌아가고,
+// 송신 FIFO가 비었다는 인터럽트(THRE)가 올 때마다 uartstart()가 채움.
+// w - r이 큐에 든 바이트 수. 링이 꽉 찼을 때만 writer가 직접 폴링함.
+#define UARTTXBUF 4096
+
+static struct {
+  struct spinlock lock;
+  char buf[UARTTXBUF];
+  uint r;     // next byte to send
+  uint w;     // next free slot
+  int txon;   // is IER_TX set?
+} uarttx;
+
+void
+uartinit(void)
+{
+  char *p;
+
+  initlock(&uarttx.lock, "uart");
+
+  // 추가: FIFO를 켜고 비움. 인터럽트 한 번에 UARTFIFO 바이트씩 보냄.
+  // 수신 트리거는 1바이트 그대로.
+  outb(COM1+2, 0x07);
+
+  // 9600 baud, 8 data bits, 1 stop bit, parity off.
+  outb(COM1+3, 0x80);    // Unlock divisor
+  outb(COM1+0, 115200/9600);
+  outb(COM1+1, 0);
+  outb(COM1+3, 0x03);    // Lock divisor, 8 data bits.
+  outb(COM1+4, 0);
+  outb(COM1+1, IER_RX);  // Enable receive interrupts.
+
+  // If status is 0xFF, no serial port.
+  if(inb(COM1+5) == 0xFF)
+    return;
+  uart = 1;
+
+  // Acknowledge pre-existing interrupt conditions;
+  // enable interrupts.
+  inb(COM1+2);
+  inb(COM1+0);
+  ioapicenable(IRQ_COM1, 0);
+
+  // Announce that we're here.
+  for(p="xv6...\n"; *p; p++)
+    uartputc(*p);
+}
+
+// 추가: 링에서 송신 FIFO가 받을 수 있는 만큼 내보내고,
+// 링에 남은 게 있을 때만 송신 인터럽트를 켜 둠.
+// Caller must hold uarttx.lock.
+static void
+uartstart(void)
+{
+  int i, on;
+
+  if(inb(COM1+5) & LSR_THRE){
+    for(i = 0; i < UARTFIFO && uarttx.r != uarttx.w; i++)
+      outb(COM1+0, uarttx.buf[uarttx.r++ % UARTTXBUF]);
+  }
+  on = uarttx.r != uarttx.w;
+  if(on != uarttx.txon){
+    uarttx.txon = on;
+    outb(COM1+1, IER_RX | (on ? IER_TX : 0));
+  }
+}
+
+// 추가: 송신 FIFO가 빌 때까지 기다렸다가 링에서 내보냄.
+// 인터럽트를 기다릴 수 없을 때 씀.
+static void
+uartpoll(void)
+{
+  int i;
+
+  for(i = 0; i < 128 && !(inb(COM1+5) & LSR_THRE); i++)
+    microdelay(10);
+  uartstart();
+}
+
+// 추가: 예전처럼 글자마다 기다리지 않고 링에 넣기만 함.
+// 링이 꽉 찼으면(이 CPU에서 인터럽트가 꺼져 있을 수도 있으므로)
+// 자리가 날 때까지 직접 폴링해서 내보냄.
+void
+uartputc(int c)
+{
+  if(!uart)
+    return;
+  acquire(&uarttx.lock);
+  while(uarttx.w - uarttx.r == UARTTXBUF)
+    uartpoll();
+  uarttx.buf[uarttx.w++ % UARTTXBUF] = c;
+  uartstart();
+  release(&uarttx.lock);
+}
+
+// 추가: 링을 전부 폴링으로 내보냄. panic()이 멈추기 전에 부름.
+// 락을 잡고 있던 CPU가 멈췄을 수 있으므로 락 없이 돎.
+void
+uartflush(void)
+{
+  if(!uart)
+    return;
+  while(uarttx.r != uarttx.w)
+    uartpoll();
+}
+
+static int
+uartgetc(void)
+{
+  if(!uart)
+    return -1;
+  if(!(inb(COM1+5) & LSR_RXRDY))
+    return -1;
+  return inb(COM1+0);
+}
+
+void
+uartintr(void)
+{
+  // 추가: 송신 FIFO가 비었으면 다시 채움.
+  // consoleintr()의 에코가 uarttx.lock을 잡으므로 먼저 놓음.
+  acquire(&uarttx.lock);
+  uartstart();
+  release(&uarttx.lock);
+
+  consoleintr(uartgetc);
+}
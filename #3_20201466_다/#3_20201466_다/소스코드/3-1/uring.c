@@ -0,0 +1,339 @@
+// 추가: 비동기 I/O 링의 커널 쪽 (uring.h 참고).
+//
+// uring_enter()는 제출 큐의 요청을 커널로 복사해 uringq에 넣기만 하고
+// 돌아감. 부팅 때 만든 NURINGWORKER개의 작업 스레드(kthread)가 uringq에서
+// 요청을 꺼내 처리하고 결과를 완료 큐에 넣음. 작업 스레드가 여럿이라
+// 한 프로세스의 요청 여러 개가 동시에 디스크에 가 있을 수 있음.
+//
+// 작업 스레드는 요청한 프로세스의 ofile과 사용자 주소를 직접 쓰지 않음.
+// 제출할 때 fd의 struct file을 filedup()해 두고, 사용자 버퍼와 링은
+// uvmwritable()로 이 프로세스만의 페이지로 붙여 둔 뒤 작업 스레드가
+// copyin()/copyout()으로 그 pgdir을 거쳐 읽고 씀. 그래서 요청이 남아
+// 있는 동안 그 페이지들이 바뀌면 안 됨. 주소 공간을 바꾸는 fork, 줄이는
+// sbrk/ssusbrk, exec, exit는 먼저 uringdrain()으로 다 끝나기를 기다림.
+//
+// 작업 스레드가 무한정 잠들지 않도록 요청은 일반 파일에만 받음
+// (파이프나 콘솔은 -1).
+//
+// uringq.lock이 uringq와 모든 struct uringctx를 보호함.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "stat.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+#include "uring.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+
+// A submitted request, owned by the kernel until it completes.
+struct ureq {
+  struct ureq *next;     // in uringq
+  struct uringctx *k;
+  struct uring_sqe e;    // copied at submission
+  struct file *f;        // filedup()ed at submission, or 0
+  int used;
+};
+
+// 프로세스마다 하나. kalloc()한 한 페이지에 들어감.
+struct uringctx {
+  struct uring *r;       // kernel address of the ring page
+  pde_t *pgdir;          // owner's page table, for copyin/copyout
+  int inflight;          // submitted but not yet completed
+  struct ureq req[URING_SQSIZE];
+};
+
+typedef char uringctx_fits[sizeof(struct uringctx) <= PGSIZE ? 1 : -1];
+
+struct {
+  struct spinlock lock;
+  struct ureq *head;     // requests waiting for a worker
+  struct ureq *tail;
+} uringq;
+
+static void uringworker(void);
+
+void
+uringinit(void)
+{
+  int i;
+
+  initlock(&uringq.lock, "uring");
+  for(i = 0; i < NURINGWORKER; i++)
+    kthread("uringd", uringworker);
+}
+
+// 완료 큐에 결과 하나를 넣음. Caller must hold uringq.lock.
+static void
+uringpost(struct uringctx *k, int user_data, int res)
+{
+  struct uring_cqe *c;
+
+  c = &k->r->cq[k->r->cqtail % URING_CQSIZE];
+  c->user_data = user_data;
+  c->res = res;
+  __sync_synchronize();  // 사용자가 cqtail보다 결과를 먼저 보도록
+  k->r->cqtail++;
+}
+
+// 요청 하나를 처리하고 해당 시스템 콜이 돌려줄 값을 돌려줌.
+// 사용자 버퍼와는 buf(한 페이지)를 거쳐 한 페이지씩 주고받음.
+static int
+uringdo(struct ureq *q, char *buf)
+{
+  struct uring_sqe *e;
+  uint addr;
+  int tot, m, r;
+
+  e = &q->e;
+  addr = (uint)e->addr;
+  switch(e->op){
+  case URING_NOP:
+    return 0;
+  case URING_FSYNC:
+    log_flush();
+    return 0;
+  case URING_READ:
+    for(tot = 0; tot < e->n; ){
+      m = min(e->n - tot, PGSIZE);
+      r = e->off < 0 ? fileread(q->f, buf, m) :
+                       filepread(q->f, buf, m, e->off + tot);
+      if(r < 0)
+        return tot > 0 ? tot : -1;
+      if(copyout(q->k->pgdir, addr + tot, buf, r) < 0)
+        return -1;
+      tot += r;
+      if(r < m)  // end of file
+        break;
+    }
+    return tot;
+  case URING_WRITE:
+    for(tot = 0; tot < e->n; ){
+      m = min(e->n - tot, PGSIZE);
+      if(copyin(q->k->pgdir, buf, addr + tot, m) < 0)
+        return -1;
+      r = e->off < 0 ? filewrite(q->f, buf, m) :
+                       filepwrite(q->f, buf, m, e->off + tot);
+      if(r < 0)
+        return tot > 0 ? tot : -1;
+      tot += r;
+      if(r < m)
+        break;
+    }
+    return tot;
+  }
+  return -1;
+}
+
+// 작업 스레드. uringq에서 요청을 꺼내 처리하고 결과를 넣음.
+static void
+uringworker(void)
+{
+  struct ureq *q;
+  struct uringctx *k;
+  char *buf;
+  int res;
+
+  if((buf = kalloc()) == 0)
+    panic("uringworker");
+  acquire(&uringq.lock);
+  for(;;){
+    while((q = uringq.head) == 0)
+      sleep(&uringq, &uringq.lock);
+    if((uringq.head = q->next) == 0)
+      uringq.tail = 0;
+    release(&uringq.lock);
+
+    res = uringdo(q, buf);
+    if(q->f)
+      fileclose(q->f);
+
+    acquire(&uringq.lock);
+    k = q->k;
+    uringpost(k, q->e.user_data, res);
+    q->used = 0;
+    k->inflight--;
+    wakeup(k);
+  }
+}
+
+// p의 링을 찾음. 처음이면 커널 쪽 상태를 만듦.
+// 제출 사이에 fork가 링 페이지를 다시 같이 쓰게 만들었을 수 있으므로
+// 매번 이 프로세스만의 페이지로 만들고 커널 주소를 새로 구함.
+static struct uringctx*
+uringget(struct proc *p)
+{
+  struct uringctx *k;
+  struct uring *r;
+
+  if(p->uring == 0 || p->uring + sizeof(struct uring) > p->sz)
+    return 0;
+  if(uvmwritable(p->pgdir, p->uring, sizeof(struct uring)) < 0 ||
+     (r = (struct uring*)uva2ka(p->pgdir, (char*)p->uring)) == 0)
+    return 0;
+  if((k = p->uringk) == 0){
+    if((k = (struct uringctx*)kalloc()) == 0)
+      return 0;
+    memset(k, 0, PGSIZE);
+    p->uringk = k;
+  }
+  acquire(&uringq.lock);
+  k->r = r;
+  k->pgdir = p->pgdir;
+  release(&uringq.lock);
+  return k;
+}
+
+// 요청 e를 작업 스레드에 넘길 수 있게 검사하고 준비함.
+// 넘길 수 없으면 -1 (그 요청의 결과가 됨).
+static int
+uringprep(struct proc *p, struct uring_sqe *e, struct file **fp)
+{
+  struct file *f;
+
+  *fp = 0;
+  if(e->op == URING_NOP)
+    return 0;
+  if(e->fd < 0 || e->fd >= NOFILE || (f=p->ofile[e->fd]) == 0)
+    return -1;
+  if(f->type != FD_INODE || f->ip->type == T_DEV)
+    return -1;
+  switch(e->op){
+  case URING_FSYNC:
+    break;
+  case URING_READ:
+  case URING_WRITE:
+    if(e->n < 0 || (uint)e->addr >= p->sz ||
+       (uint)e->addr + e->n > p->sz)
+      return -1;
+    if(uvmwritable(p->pgdir, (uint)e->addr, e->n) < 0)
+      return -1;
+    break;
+  default:
+    return -1;
+  }
+  *fp = filedup(f);
+  return 0;
+}
+
+// 제출 큐에서 요청을 최대 n개(음수면 전부) 꺼내 작업 스레드에 넘김.
+// 처리 중인 요청과 완료 큐에 남은 결과가 완료 큐를 넘치지 않을
+// 만큼만 받음. 넘긴 개수를 돌려줌.
+int
+uringsubmit(int n)
+{
+  struct proc *p = myproc();
+  struct uringctx *k;
+  struct uring *r;
+  struct uring_sqe e;
+  struct ureq *q;
+  struct file *f;
+  uint head, tail;
+  int done, ok, m, budget;
+
+  // ssusbrk가 예약한 해제는 타이머가 하므로 기다릴 수 없음
+  if(p->dealloc_bool || (k = uringget(p)) == 0)
+    return -1;
+  r = k->r;
+  head = r->sqhead;
+  tail = r->sqtail;
+  if(tail - head > URING_SQSIZE)
+    return -1;
+  if(n < 0 || n > tail - head)
+    n = tail - head;
+
+  // 읽기 요청은 블록을 먼저 readahead로 디스크에 맡겨 둠. 버퍼 캐시를
+  // 다 차지하지 않도록 합쳐서 URING_PFMAX 블록까지만 하고, 빈 버퍼가
+  // 모자라면 그만둠.
+  budget = URING_PFMAX * BSIZE;
+  for(done = 0; done < n; done++){
+    // 완료 큐와 요청 자리는 작업 스레드가 늘리기만 하므로 여기서 본
+    // 빈 자리는 아래에서 넣을 때까지 그대로 있음.
+    acquire(&uringq.lock);
+    ok = k->inflight < URING_SQSIZE &&
+         r->cqtail - r->cqhead + k->inflight < URING_CQSIZE;
+    release(&uringq.lock);
+    if(!ok)
+      break;
+
+    e = r->sq[head % URING_SQSIZE];  // 사용자가 바꿔도 되도록 복사해 둠
+    ok = uringprep(p, &e, &f) == 0;
+    if(ok && e.op == URING_READ && budget > 0){
+      m = min(e.n, budget);
+      if(fileprefetch(f, e.off, m) < 0)
+        budget = 0;
+      else
+        budget -= m;
+    }
+
+    acquire(&uringq.lock);
+    if(!ok)
+      uringpost(k, e.user_data, -1);
+    else {
+      for(q = k->req; q->used; q++)
+        ;
+      q->used = 1;
+      q->next = 0;
+      q->k = k;
+      q->e = e;
+      q->f = f;
+      if(uringq.tail)
+        uringq.tail->next = q;
+      else
+        uringq.head = q;
+      uringq.tail = q;
+      k->inflight++;
+      wakeup(&uringq);
+    }
+    r->sqhead = ++head;
+    release(&uringq.lock);
+  }
+  return done;
+}
+
+// 완료 큐에 결과가 wait개 이상 쌓이거나 처리 중인 요청이 없을 때까지
+// 기다림.
+void
+uringwait(int wait)
+{
+  struct proc *p = myproc();
+  struct uringctx *k;
+
+  if((k = p->uringk) == 0)
+    return;
+  acquire(&uringq.lock);
+  while(k->inflight > 0 && k->r->cqtail - k->r->cqhead < wait && !p->killed)
+    sleep(k, &uringq.lock);
+  release(&uringq.lock);
+}
+
+// p가 넘긴 요청이 모두 끝날 때까지 기다림.
+// p의 주소 공간을 바꾸거나 줄이기 전에 부름.
+void
+uringdrain(struct proc *p)
+{
+  struct uringctx *k;
+
+  if((k = p->uringk) == 0)
+    return;
+  acquire(&uringq.lock);
+  while(k->inflight > 0)
+    sleep(k, &uringq.lock);
+  release(&uringq.lock);
+}
+
+// exec와 exit에서. 요청이 끝나기를 기다린 뒤 커널 쪽 상태를 버림.
+void
+uringfree(struct proc *p)
+{
+  uringdrain(p);
+  if(p->uringk){
+    kfree((char*)p->uringk);
+    p->uringk = 0;
+  }
+}
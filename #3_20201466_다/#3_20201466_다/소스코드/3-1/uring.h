@@ -0,0 +1,41 @@
+// 추가: 비동기 I/O 링 (io_uring 비슷한 것).
+// uring_setup()이 프로세스 주소 공간에 한 페이지짜리 struct uring을
+// 만들어 주소를 돌려줌. 사용자는 sq[]에 요청을 채우고 sqtail을 올린 뒤
+// uring_enter(n, wait)를 부름. 커널은 sqhead부터 요청을 최대 n개 가져가
+// 바로 돌아가고, 커널 작업 스레드가 요청을 처리하는 대로 결과를 cq[]에
+// 넣은 뒤 cqtail을 올림. 결과의 순서는 제출 순서와 다를 수 있음.
+// wait가 양수면 결과가 wait개 쌓일 때까지 기다렸다가 돌아감.
+// 사용자는 결과를 읽고 cqhead를 올림. 요청의 버퍼는 결과가 올 때까지
+// 건드리지 않아야 함. 요청은 일반 파일에만 쓸 수 있음.
+// 인덱스는 계속 증가하고 배열 위치는 크기로 나눈 나머지임.
+
+#define URING_NOP    0
+#define URING_READ   1
+#define URING_WRITE  2
+#define URING_FSYNC  3
+
+#define URING_SQSIZE 64
+#define URING_CQSIZE 128
+
+struct uring_sqe {
+  int op;         // URING_*
+  int fd;
+  char *addr;     // user buffer
+  int n;          // bytes
+  int off;        // file offset, or -1 to use and advance the fd's offset
+  int user_data;  // copied to the completion
+};
+
+struct uring_cqe {
+  int user_data;
+  int res;        // what read/write/fsync would have returned
+};
+
+struct uring {
+  volatile uint sqhead;   // written by the kernel
+  volatile uint sqtail;   // written by the user
+  volatile uint cqhead;   // written by the user
+  volatile uint cqtail;   // written by the kernel
+  struct uring_sqe sq[URING_SQSIZE];
+  struct uring_cqe cq[URING_CQSIZE];
+};
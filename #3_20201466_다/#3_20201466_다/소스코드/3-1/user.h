@@ -1,5 +1,6 @@
 struct stat;
 struct rtcdate;
+struct uring;
 
 // system calls
 int fork(void);
@@ -23,8 +24,21 @@ int getpid(void);
 char* sbrk(int);
 int sleep(int);
 int uptime(void);
+uint uptimeus(void);
 int ssusbrk(int size, int ticks);
 int memstat(void);
+int fsync(int);
+int splice(int, int, int);
+int copy_file_range(int, int, int);
+int fallocate(int, int, int);
+int ftruncate(int, int);
+int lseek(int, int, int);
+int pread(int, void*, int, int);
+int pwrite(int, void*, int, int);
+int trace(int, int);
+int sysstat(void);
+struct uring* uring_setup(void);
+int uring_enter(int, int);
 
 // ulib.c
 int stat(const char*, struct stat*);
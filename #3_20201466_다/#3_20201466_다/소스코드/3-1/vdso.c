@@ -0,0 +1,43 @@
+// 추가: vDSO 페이지(vdso.h)를 읽는 사용자 라이브러리.
+// 시스템 콜(트랩) 없이 값을 돌려줌.
+
+#include "types.h"
+#include "user.h"
+#include "vdso.h"
+
+int
+getpid(void)
+{
+  return VDSOPROC->pid;
+}
+
+int
+uptime(void)
+{
+  return VDSODATA->ticks;
+}
+
+// 부팅 후 마이크로초. 마지막 tick 이후는 TSC로 보간함.
+uint
+uptimeus(void)
+{
+  uint seq, t, tsc, per, lo, hi, us;
+
+  do {
+    seq = VDSODATA->seq;
+    __sync_synchronize();
+    t = VDSODATA->ticks;
+    tsc = VDSODATA->tsc;
+    per = VDSODATA->tscperus;
+    __sync_synchronize();
+  } while((seq & 1) || seq != VDSODATA->seq);
+
+  us = 0;
+  if(per){
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    us = (lo - tsc) / per;
+    if(us >= VDSO_USPERTICK)
+      us = VDSO_USPERTICK - 1;
+  }
+  return t * VDSO_USPERTICK + us;
+}
@@ -0,0 +1,20 @@
+// 추가: vDSO. 모든 프로세스의 VDSOBASE에 읽기 전용으로 붙는 두 페이지.
+// 첫 페이지(vdsodata)는 모두가 같이 보고 타이머 인터럽트가 고침.
+// 둘째 페이지(vdsoproc)는 프로세스마다 따로 있음.
+// 사용자 라이브러리(vdso.c)는 uptime()과 getpid()를 트랩 없이 여기서 읽음.
+
+#define VDSOBASE       0x7FFFE000   // KERNBASE - 2*PGSIZE; user memory ends here
+#define VDSODATA       ((struct vdsodata*)VDSOBASE)
+#define VDSOPROC       ((struct vdsoproc*)(VDSOBASE + 4096))
+#define VDSO_USPERTICK 10000        // a tick is nominally 10ms
+
+struct vdsodata {
+  volatile uint seq;       // odd while the timer is updating the rest
+  volatile uint ticks;
+  volatile uint tsc;       // low 32 bits of the TSC at that tick
+  volatile uint tscperus;  // TSC calibration: cycles per microsecond
+};
+
+struct vdsoproc {
+  int pid;
+};
@@ -0,0 +1,319 @@
+// 추가: virtio-blk disk driver (legacy virtio-pci interface).
+// QEMU의 -drive if=virtio로 붙인 디스크를 루트 디바이스로 씀.
+// 요청마다 디스크립터 3개(헤더, 데이터, 상태)를 쓰고,
+// 큐가 허락하는 만큼 여러 요청을 동시에 장치에 맡겨 둠.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "x86.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+
+// Legacy virtio-pci registers, relative to BAR0.
+#define VIRTIO_HOST_FEATURES  0x00
+#define VIRTIO_GUEST_FEATURES 0x04
+#define VIRTIO_QUEUE_PFN      0x08
+#define VIRTIO_QUEUE_SIZE     0x0c
+#define VIRTIO_QUEUE_SEL      0x0e
+#define VIRTIO_QUEUE_NOTIFY   0x10
+#define VIRTIO_STATUS         0x12
+#define VIRTIO_ISR            0x13
+
+// Device status bits.
+#define VIRTIO_ST_ACK         1
+#define VIRTIO_ST_DRIVER      2
+#define VIRTIO_ST_DRIVER_OK   4
+#define VIRTIO_ST_FAILED      128
+
+#define VRING_DESC_F_NEXT     1
+#define VRING_DESC_F_WRITE    2   // device writes (vs reads)
+
+#define VIRTIO_BLK_T_IN       0   // read the disk
+#define VIRTIO_BLK_T_OUT      1   // write the disk
+
+#define VQMAX                 256 // largest queue we have room for
+
+struct vring_desc {
+  unsigned long long addr;
+  uint len;
+  ushort flags;
+  ushort next;
+};
+
+struct vring_avail {
+  ushort flags;
+  ushort idx;
+  ushort ring[];
+};
+
+struct vring_used_elem {
+  uint id;
+  uint len;
+};
+
+struct vring_used {
+  ushort flags;
+  ushort idx;
+  struct vring_used_elem ring[];
+};
+
+struct virtio_blk_req {
+  uint type;
+  uint reserved;
+  unsigned long long sector;
+};
+
+// The legacy layout: descriptors, then the available ring,
+// then the used ring on the next page boundary.
+#define VRING_SIZE(n) \
+  (PGROUNDUP(16*(n) + 2*(3+(n))) + PGROUNDUP(6 + 8*(n)))
+
+// The ring must be physically contiguous, so it lives in the
+// kernel's bss rather than in pages from kalloc().
+static char vqmem[VRING_SIZE(VQMAX)] __attribute__((aligned(PGSIZE)));
+
+static struct {
+  struct spinlock lock;
+  uint iobase;
+  uint num;                 // queue size chosen by the device
+  struct vring_desc *desc;
+  struct vring_avail *avail;
+  struct vring_used *used;
+  ushort usedidx;           // next used entry to look at
+  char free[VQMAX];         // is a descriptor free?
+  int nfree;
+  // Per request, indexed by the head descriptor.
+  struct buf *b[VQMAX];
+  struct virtio_blk_req req[VQMAX];
+  uchar status[VQMAX];
+} vq;
+
+int havevirtio;
+int virtioirq;
+
+void
+virtioinit(void)
+{
+  int addr, i;
+  uint iobase, n;
+
+  if((addr = pcifind(0x1af4, 0x1001)) < 0)
+    return;
+  // BAR0 is the legacy I/O register block.
+  iobase = pciread(addr, 0x10) & 0xfffc;
+  if(iobase == 0)
+    return;
+  // Enable I/O space and bus master.
+  pciwrite(addr, 0x04, (pciread(addr, 0x04) & 0xffff) | 0x5);
+
+  outb(iobase + VIRTIO_STATUS, 0);  // reset
+  outb(iobase + VIRTIO_STATUS, VIRTIO_ST_ACK);
+  outb(iobase + VIRTIO_STATUS, VIRTIO_ST_ACK | VIRTIO_ST_DRIVER);
+  outl(iobase + VIRTIO_GUEST_FEATURES, 0);  // no optional features
+
+  outw(iobase + VIRTIO_QUEUE_SEL, 0);
+  n = inw(iobase + VIRTIO_QUEUE_SIZE);
+  if(n == 0 || n > VQMAX){
+    outb(iobase + VIRTIO_STATUS, VIRTIO_ST_FAILED);
+    return;
+  }
+
+  initlock(&vq.lock, "virtio");
+  vq.iobase = iobase;
+  vq.num = n;
+  memset(vqmem, 0, sizeof(vqmem));
+  vq.desc = (struct vring_desc*)vqmem;
+  vq.avail = (struct vring_avail*)(vqmem + 16*n);
+  vq.used = (struct vring_used*)(vqmem + PGROUNDUP(16*n + 2*(3+n)));
+  for(i = 0; i < n; i++)
+    vq.free[i] = 1;
+  vq.nfree = n;
+  outl(iobase + VIRTIO_QUEUE_PFN, V2P(vqmem) / PGSIZE);
+
+  outb(iobase + VIRTIO_STATUS,
+       VIRTIO_ST_ACK | VIRTIO_ST_DRIVER | VIRTIO_ST_DRIVER_OK);
+
+  virtioirq = pciread(addr, 0x3c) & 0xff;
+  ioapicenable(virtioirq, ncpu - 1);
+  havevirtio = 1;
+}
+
+// Take a free descriptor.  Caller must hold vq.lock
+// and have checked vq.nfree.
+static int
+vqalloc(void)
+{
+  int i;
+
+  for(i = 0; i < vq.num; i++){
+    if(vq.free[i]){
+      vq.free[i] = 0;
+      vq.nfree--;
+      return i;
+    }
+  }
+  panic("vqalloc");
+}
+
+// Free the descriptor chain starting at head.
+static void
+vqfree(int head)
+{
+  int i;
+
+  for(i = head; ; i = vq.desc[i].next){
+    vq.free[i] = 1;
+    vq.nfree++;
+    if(!(vq.desc[i].flags & VRING_DESC_F_NEXT))
+      break;
+  }
+  wakeup(&vq.free);
+}
+
+// Put the request for b on the available ring.
+// The device is not told until the caller notifies it.
+// Caller must hold vq.lock.
+static void
+vqsubmit(struct buf *b)
+{
+  int d[3];
+
+  while(vq.nfree < 3)
+    sleep(&vq.free, &vq.lock);
+  d[0] = vqalloc();
+  d[1] = vqalloc();
+  d[2] = vqalloc();
+
+  vq.req[d[0]].type = (b->flags & B_DIRTY) ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+  vq.req[d[0]].reserved = 0;
+  vq.req[d[0]].sector = b->blockno * (BSIZE / 512);
+  vq.b[d[0]] = b;
+  vq.status[d[0]] = 0xff;
+
+  vq.desc[d[0]].addr = V2P(&vq.req[d[0]]);
+  vq.desc[d[0]].len = sizeof(struct virtio_blk_req);
+  vq.desc[d[0]].flags = VRING_DESC_F_NEXT;
+  vq.desc[d[0]].next = d[1];
+
+  vq.desc[d[1]].addr = V2P(b->data);
+  vq.desc[d[1]].len = BSIZE;
+  vq.desc[d[1]].flags = VRING_DESC_F_NEXT;
+  if(!(b->flags & B_DIRTY))
+    vq.desc[d[1]].flags |= VRING_DESC_F_WRITE;
+  vq.desc[d[1]].next = d[2];
+
+  vq.desc[d[2]].addr = V2P(&vq.status[d[0]]);
+  vq.desc[d[2]].len = 1;
+  vq.desc[d[2]].flags = VRING_DESC_F_WRITE;
+  vq.desc[d[2]].next = 0;
+
+  vq.avail->ring[vq.avail->idx % vq.num] = d[0];
+  __sync_synchronize();  // the device must see the ring entry first
+  vq.avail->idx++;
+}
+
+// Tell the device there are new requests.
+static void
+vqnotify(void)
+{
+  __sync_synchronize();
+  outw(vq.iobase + VIRTIO_QUEUE_NOTIFY, 0);
+}
+
+static void
+vqcheck(struct buf *b)
+{
+  if(!holdingsleep(&b->lock))
+    panic("virtiorw: buf not locked");
+  if((b->flags & (B_VALID|B_DIRTY)) == B_VALID)
+    panic("virtiorw: nothing to do");
+  if(b->blockno >= FSSIZE)
+    panic("virtiorw: block out of range");
+}
+
+// Sync bufs with disk, like iderwv(), with all of them
+// in flight at once.
+void
+virtiorwv(struct buf **bs, int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++)
+    vqcheck(bs[i]);
+
+  acquire(&vq.lock);
+  for(i = 0; i < n; i++){
+    vqsubmit(bs[i]);
+    // Let the device start before we may sleep for descriptors.
+    if(vq.nfree < 3)
+      vqnotify();
+  }
+  vqnotify();
+
+  for(i = 0; i < n; i++){
+    while((bs[i]->flags & (B_VALID|B_DIRTY)) != B_VALID)
+      sleep(bs[i], &vq.lock);
+  }
+  release(&vq.lock);
+}
+
+void
+virtiorw(struct buf *b)
+{
+  virtiorwv(&b, 1);
+}
+
+// Readahead: submit and return; virtiointr() calls bdone().
+void
+virtiorw_async(struct buf *b)
+{
+  vqcheck(b);
+  if(!(b->flags & B_ASYNC))
+    panic("virtiorw_async: not a readahead");
+
+  acquire(&vq.lock);
+  vqsubmit(b);
+  vqnotify();
+  release(&vq.lock);
+}
+
+// Interrupt handler.
+void
+virtiointr(void)
+{
+  struct vring_used_elem *e;
+  struct buf *b;
+
+  acquire(&vq.lock);
+
+  // Reading the ISR acknowledges the interrupt.  Do it before
+  // looking at the used ring so a completion after the scan
+  // raises a new interrupt.
+  inb(vq.iobase + VIRTIO_ISR);
+  __sync_synchronize();
+
+  while(vq.usedidx != vq.used->idx){
+    __sync_synchronize();
+    e = &vq.used->ring[vq.usedidx % vq.num];
+    b = vq.b[e->id];
+    if(b == 0 || vq.status[e->id] != 0)
+      panic("virtiointr");
+    vq.b[e->id] = 0;
+    vqfree(e->id);
+    vq.usedidx++;
+
+    b->flags |= B_VALID;
+    b->flags &= ~B_DIRTY;
+    wakeup(b);
+    if(b->flags & B_ASYNC)
+      bdone(b);
+  }
+
+  release(&vq.lock);
+}
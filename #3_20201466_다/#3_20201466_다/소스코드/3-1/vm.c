@@ -6,6 +6,7 @@
 #include "mmu.h"
 #include "proc.h"
 #include "elf.h"
+#include "vdso.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
@@ -29,9 +30,65 @@ seginit(void)
   lgdt(c->gdt, sizeof(c->gdt));
 }
 
+// 추가: 4MB 슈퍼페이지 하나를 같은 물리 페이지를 가리키는 4KB PTE
+// NPTENTRIES개로 쪼갬. 물리 페이지마다 ref가 따로 있으므로 쪼갠 뒤에는
+// 보통 페이지와 똑같이 다룰 수 있음. 주소 변환은 그대로라 TLB는 놔둠.
+static int
+splitsuper(pde_t *pde)
+{
+  pte_t *pgtab;
+  uint pa, flags, i;
+
+  if((pgtab = (pte_t*)kalloc()) == 0)
+    return -1;
+  pa = PTE_ADDR(*pde);
+  flags = PTE_FLAGS(*pde) & ~PTE_PS;
+  for(i = 0; i < NPTENTRIES; i++)
+    pgtab[i] = (pa + i*PGSIZE) | flags;
+  *pde = V2P(pgtab) | PTE_P | PTE_W | PTE_U;
+  return 0;
+}
+
+// 추가: va가 든 4MB 영역이 전부 sz 안에 있고 아직 아무것도 붙어 있지
+// 않으면 0으로 채운 슈퍼페이지(PTE_PS) 하나로 붙임.
+// 연속한 물리 메모리가 없거나 조건이 안 맞으면 -1이고,
+// 호출한 쪽은 4KB 페이지로 하면 됨.
+int
+superalloc(pde_t *pgdir, uint va, uint sz)
+{
+  uint base;
+  char *mem;
+
+  base = va & ~(SUPERPGSIZE-1);
+  if(base + SUPERPGSIZE > sz || base + SUPERPGSIZE < base)
+    return -1;
+  if(pgdir[PDX(base)] & PTE_P)
+    return -1;
+  if((mem = kallocsuper()) == 0)
+    return -1;
+  memset(mem, 0, SUPERPGSIZE);
+  pgdir[PDX(base)] = V2P(mem) | PTE_P | PTE_W | PTE_U | PTE_PS;
+  return 0;
+}
+
+// 추가: va가 슈퍼페이지에 있으면 4KB 페이지로 쪼갬.
+// 4KB 단위로 PTE를 바꿔야 하는 곳에서만 부름.
+static int
+uvmsplit(pde_t *pgdir, const void *va)
+{
+  pde_t *pde;
+
+  pde = &pgdir[PDX(va)];
+  if((*pde & PTE_PS) && splitsuper(pde) < 0)
+    return -1;
+  return 0;
+}
+
 // Return the address of the PTE in page table pgdir
 // that corresponds to virtual address va.  If alloc!=0,
 // create any required page table pages.
+// 추가: 슈퍼페이지에 있는 va면 alloc!=0일 때만 쪼개고, 아니면 PDE 자체를
+// 돌려줌 (PTE_PS가 켜져 있음). 물리 주소는 ptepa()로 구함.
 // static이 원래 있었음
 pte_t *
 walkpgdir(pde_t *pgdir, const void *va, int alloc)
@@ -40,6 +97,12 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
   pte_t *pgtab;
 
   pde = &pgdir[PDX(va)];
+  if(*pde & PTE_PS){
+    if(!alloc)
+      return pde;
+    if(splitsuper(pde) < 0)
+      return 0;
+  }
   if(*pde & PTE_P){
     pgtab = (pte_t*)P2V(PTE_ADDR(*pde));
   } else {
@@ -55,6 +118,15 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
   return &pgtab[PTX(va)];
 }
 
+// 추가: walkpgdir()가 돌려준 pte에서 va가 든 4KB 페이지의 물리 주소를 구함.
+uint
+ptepa(pte_t *pte, const void *va)
+{
+  if(*pte & PTE_PS)
+    return PTE_ADDR(*pte) + PTX(va)*PGSIZE;
+  return PTE_ADDR(*pte);
+}
+
 // Create PTEs for virtual addresses starting at va that refer to
 // physical addresses starting at pa. va and size might not
 // be page-aligned.
@@ -137,6 +209,8 @@ setupkvm(void)
   return pgdir;
 }
 
+char *zeropage;  // 추가: 읽기만 한 지연 할당 페이지가 모두 가리키는 페이지
+
 // Allocate one page table for the machine for the kernel address
 // space for scheduler processes.
 void
@@ -144,6 +218,12 @@ kvmalloc(void)
 {
   kpgdir = setupkvm();
   switchkvm();
+
+  // 추가: 공용 0 페이지. 커널이 참조 하나를 계속 쥐고 있으므로
+  // 절대 해제되지 않고, cowcopy()는 항상 사본을 만듦.
+  if((zeropage = kalloc()) == 0)
+    panic("kvmalloc: zeropage");
+  memset(zeropage, 0, PGSIZE);
 }
 
 // Switch h/w page table register to the kernel-only page table,
@@ -171,6 +251,9 @@ switchuvm(struct proc *p)
   mycpu()->gdt[SEG_TSS].s = 0;
   mycpu()->ts.ss0 = SEG_KDATA << 3;
   mycpu()->ts.esp0 = (uint)p->kstack + KSTACKSIZE;
+  // 추가: sysenter도 같은 커널 스택에서 시작함
+  if(havesysenter)
+    wrmsr(MSR_SYSENTER_ESP, (uint)p->kstack + KSTACKSIZE, 0);
   // setting IOPL=0 in eflags *and* iomb beyond the tss segment limit
   // forbids I/O instructions (e.g., inb and outb) from user space
   mycpu()->ts.iomb = (ushort) 0xFFFF;
@@ -207,7 +290,7 @@ loaduvm(pde_t *pgdir, char *addr, struct inode *ip, uint offset, uint sz)
   for(i = 0; i < sz; i += PGSIZE){
     if((pte = walkpgdir(pgdir, addr+i, 0)) == 0)
       panic("loaduvm: address should exist");
-    pa = PTE_ADDR(*pte);
+    pa = ptepa(pte, addr+i);
     if(sz - i < PGSIZE)
       n = sz - i;
     else
@@ -226,13 +309,18 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
   char *mem;
   uint a;
 
-  if(newsz >= KERNBASE)
+  if(newsz > VDSOBASE)  // 추가: vDSO 페이지 아래까지만
     return 0;
   if(newsz < oldsz)
     return oldsz;
 
   a = PGROUNDUP(oldsz);
   for(; a < newsz; a += PGSIZE){
+    // 추가: 4MB 영역 전체가 새로 생기면 슈퍼페이지로 붙여 봄
+    if(a % SUPERPGSIZE == 0 && superalloc(pgdir, a, newsz) == 0){
+      a += SUPERPGSIZE - PGSIZE;
+      continue;
+    }
     mem = kalloc();
     if(mem == 0){
       cprintf("allocuvm out of memory\n");
@@ -254,17 +342,36 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 // newsz.  oldsz and newsz need not be page-aligned, nor does newsz
 // need to be less than oldsz.  oldsz can be larger than the actual
 // process size.  Returns the new process size.
+// 추가: newsz가 슈퍼페이지 가운데에 있는데 쪼갤 페이지 테이블 페이지를
+// 얻지 못하면 아무것도 놓아주지 않고 0을 돌려줌.
 int
 deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 {
+  pde_t *pde;
   pte_t *pte;
-  uint a, pa;
+  uint a, pa, i;
 
   if(newsz >= oldsz)
     return oldsz;
 
   a = PGROUNDUP(newsz);
+  // 추가: 일부만 없어지는 슈퍼페이지는 이것 하나뿐이므로 먼저 쪼개 둠.
+  // 그 뒤의 슈퍼페이지는 4MB 전체가 newsz 위에 있음.
+  pde = &pgdir[PDX(a)];
+  if(a < oldsz && (*pde & PTE_PS) && a % SUPERPGSIZE != 0 &&
+     splitsuper(pde) < 0)
+    return 0;
   for(; a  < oldsz; a += PGSIZE){
+    // 추가: 슈퍼페이지는 쪼개지 않고 한 번에 놓아줌
+    pde = &pgdir[PDX(a)];
+    if(*pde & PTE_PS){
+      pa = PTE_ADDR(*pde);
+      for(i = 0; i < NPTENTRIES; i++)
+        kfree(P2V(pa + i*PGSIZE));
+      *pde = 0;
+      a += SUPERPGSIZE - PGSIZE;
+      continue;
+    }
     pte = walkpgdir(pgdir, (char*)a, 0);
     if(!pte)
       a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
@@ -289,7 +396,8 @@ freevm(pde_t *pgdir)
 
   if(pgdir == 0)
     panic("freevm: no pgdir");
-  deallocuvm(pgdir, KERNBASE, 0);
+  // 추가: vDSO 페이지는 이 프로세스 것이 아니므로 놔둠
+  deallocuvm(pgdir, VDSOBASE, 0);
   for(i = 0; i < NPDENTRIES; i++){
     if(pgdir[i] & PTE_P){
       char * v = P2V(PTE_ADDR(pgdir[i]));
@@ -299,6 +407,18 @@ freevm(pde_t *pgdir)
   kfree((char*)pgdir);
 }
 
+// 추가: vDSO의 두 페이지를 pgdir의 VDSOBASE에 읽기 전용으로 붙임.
+// 둘 다 프로세스 메모리(sz) 밖이라 copyuvm과 freevm이 건드리지 않음.
+int
+vdsomap(pde_t *pgdir, struct proc *p)
+{
+  if(mappages(pgdir, (char*)VDSOBASE, PGSIZE, V2P(vdsopage), PTE_U) < 0)
+    return -1;
+  if(mappages(pgdir, (char*)VDSOBASE+PGSIZE, PGSIZE, V2P(p->vdso), PTE_U) < 0)
+    return -1;
+  return 0;
+}
+
 // Clear PTE_U on a page. Used to create an inaccessible
 // page beneath the user stack.
 void
@@ -306,43 +426,124 @@ clearpteu(pde_t *pgdir, char *uva)
 {
   pte_t *pte;
 
-  pte = walkpgdir(pgdir, uva, 0);
-  if(pte == 0)
+  if(uvmsplit(pgdir, uva) < 0 || (pte = walkpgdir(pgdir, uva, 0)) == 0)
     panic("clearpteu");
   *pte &= ~PTE_U;
 }
 
 // Given a parent process's page table, create a copy
 // of it for a child.
+// 추가: 페이지를 복사하지 않고 자식과 같이 씀 (copy-on-write).
+// 쓰기 가능한 페이지는 양쪽 다 읽기 전용 + PTE_COW로 바꿔 두고,
+// 먼저 쓰는 쪽이 페이지 폴트에서 cowcopy()로 자기 사본을 만듦.
+// ssusbrk로 잡아 두고 아직 건드리지 않은 페이지는 자식에서도 비워 둠.
 pde_t*
 copyuvm(pde_t *pgdir, uint sz)
 {
-  pde_t *d;
+  pde_t *d, *pde;
   pte_t *pte;
-  uint pa, i, flags;
-  char *mem;
+  uint pa, i, j, flags;
 
   if((d = setupkvm()) == 0)
     return 0;
   for(i = 0; i < sz; i += PGSIZE){
-    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
-      panic("copyuvm: pte should exist");
-    if(!(*pte & PTE_P))
-      panic("copyuvm: page not present");
+    // 추가: 슈퍼페이지는 PDE째로 같이 씀. 자식이나 부모가 쓰면
+    // cowcopy()가 uvmsplit()으로 쪼갠 뒤 그 4KB만 복사함.
+    pde = &pgdir[PDX(i)];
+    if(*pde & PTE_PS){
+      if(*pde & PTE_W)
+        *pde = (*pde & ~PTE_W) | PTE_COW;
+      d[PDX(i)] = *pde;
+      for(j = 0; j < NPTENTRIES; j++)
+        kref(P2V(PTE_ADDR(*pde) + j*PGSIZE));
+      i += SUPERPGSIZE - PGSIZE;
+      continue;
+    }
+    if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0 || !(*pte & PTE_P))
+      continue;  // 추가: 지연 할당 페이지
+    if(*pte & PTE_W)
+      *pte = (*pte & ~PTE_W) | PTE_COW;
     pa = PTE_ADDR(*pte);
     flags = PTE_FLAGS(*pte);
-    if((mem = kalloc()) == 0)
+    if(mappages(d, (void*)i, PGSIZE, pa, flags) < 0)
       goto bad;
-    memmove(mem, (char*)P2V(pa), PGSIZE);
-    if(mappages(d, (void*)i, PGSIZE, V2P(mem), flags) < 0) {
-      kfree(mem);
-      goto bad;
-    }
+    kref(P2V(pa));
   }
+  // 부모의 PTE를 읽기 전용으로 바꿨으므로 TLB를 비움
+  if(myproc() && myproc()->pgdir == pgdir)
+    lcr3(V2P(pgdir));
   return d;
 
 bad:
   freevm(d);
+  if(myproc() && myproc()->pgdir == pgdir)
+    lcr3(V2P(pgdir));
+  return 0;
+}
+
+// 추가: copy-on-write 페이지에 쓰려다 난 페이지 폴트를 처리함.
+// va가 그런 페이지가 아니면 -1. 같이 쓰는 곳이 없으면 복사 없이
+// 다시 쓰기 가능으로 바꾸고, 있으면 사본을 만들어 바꿔 끼움.
+// 공용 0 페이지는 참조를 세지 않으므로 언제나 새 페이지를 만듦.
+int
+cowcopy(pde_t *pgdir, uint va)
+{
+  pte_t *pte;
+  char *old, *mem;
+
+  if(va >= VDSOBASE || uvmsplit(pgdir, (void*)va) < 0 ||
+     (pte = walkpgdir(pgdir, (void*)va, 0)) == 0)
+    return -1;
+  if((*pte & (PTE_P|PTE_U|PTE_COW)) != (PTE_P|PTE_U|PTE_COW))
+    return -1;
+  old = P2V(PTE_ADDR(*pte));
+  if(old == zeropage || krefcount(old) > 1){
+    if((mem = kalloc()) == 0)
+      return -1;
+    if(old == zeropage)
+      memset(mem, 0, PGSIZE);
+    else
+      memmove(mem, old, PGSIZE);
+    *pte = V2P(mem) | PTE_FLAGS(*pte);
+    kfree(old);
+  }
+  *pte = (*pte & ~PTE_COW) | PTE_W;
+  lcr3(V2P(pgdir));
+  return 0;
+}
+
+// 추가: 커널이 va부터 n바이트에 쓰기 전에 copy-on-write 페이지를 미리
+// 이 프로세스만의 페이지로 바꿔 둠. 커널 모드의 폴트에서는 메모리가
+// 모자라도 돌아갈 곳이 없기 때문. 아직 붙지 않은 지연 할당 페이지도
+// 0으로 채운 페이지를 붙여 둠 (uring 작업 스레드는 폴트 없이
+// copyin/copyout하므로). 호출한 쪽이 범위가 sz 안인지 확인해야 함.
+// 메모리가 모자라면 -1.
+int
+uvmwritable(pde_t *pgdir, uint va, uint n)
+{
+  pte_t *pte;
+  char *mem;
+  uint a, last;
+
+  if(n == 0)
+    return 0;
+  a = PGROUNDDOWN(va);
+  last = PGROUNDDOWN(va + n - 1);
+  for(;; a += PGSIZE){
+    pte = walkpgdir(pgdir, (char*)a, 0);
+    if(pte == 0 || (*pte & PTE_P) == 0){
+      if((mem = kalloc()) == 0)
+        return -1;
+      memset(mem, 0, PGSIZE);
+      if(mappages(pgdir, (char*)a, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
+        kfree(mem);
+        return -1;
+      }
+    } else if((*pte & PTE_COW) && cowcopy(pgdir, a) < 0)
+      return -1;
+    if(a == last)
+      break;
+  }
   return 0;
 }
 
@@ -354,11 +555,13 @@ uva2ka(pde_t *pgdir, char *uva)
   pte_t *pte;
 
   pte = walkpgdir(pgdir, uva, 0);
+  if(pte == 0)  // 추가: 페이지 테이블이 없는 지연 할당 영역
+    return 0;
   if((*pte & PTE_P) == 0)
     return 0;
   if((*pte & PTE_U) == 0)
     return 0;
-  return (char*)P2V(PTE_ADDR(*pte));
+  return (char*)P2V(ptepa(pte, uva));
 }
 
 // Copy len bytes from p to user address va in page table pgdir.
@@ -387,6 +590,31 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
   return 0;
 }
 
+// 추가: copyout의 반대. pgdir의 사용자 주소 va에서 len바이트를 p로 읽음.
+// uring 작업 스레드가 요청한 프로세스의 버퍼를 읽을 때 씀.
+int
+copyin(pde_t *pgdir, void *p, uint va, uint len)
+{
+  char *buf, *pa0;
+  uint n, va0;
+
+  buf = (char*)p;
+  while(len > 0){
+    va0 = (uint)PGROUNDDOWN(va);
+    pa0 = uva2ka(pgdir, (char*)va0);
+    if(pa0 == 0)
+      return -1;
+    n = PGSIZE - (va - va0);
+    if(n > len)
+      n = len;
+    memmove(buf, pa0 + (va - va0), n);
+    len -= n;
+    buf += n;
+    va = va0 + PGSIZE;
+  }
+  return 0;
+}
+
 //PAGEBREAK!
 // Blank page.
 //PAGEBREAK!